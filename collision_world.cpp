@@ -0,0 +1,419 @@
+#include <cmath>
+#include <algorithm>
+
+#include "collision_world.h"
+
+namespace game {
+
+CollisionWorld::CollisionWorld(float cell_size){
+
+    cell_size_ = cell_size;
+    pair_tests_ = 0;
+}
+
+
+CollisionWorld::~CollisionWorld(){
+}
+
+
+BodyHandle CollisionWorld::AddBody(const glm::vec3 &position, float radius, unsigned int layer, unsigned int mask, int data){
+
+    unsigned int index;
+    if (!free_body_.empty()){
+        index = free_body_.back();
+        free_body_.pop_back();
+    } else {
+        index = body_.size();
+        body_.push_back(CollisionBody());
+        body_[index].generation = 0;
+    }
+
+    CollisionBody &body = body_[index];
+    body.position = position;
+    body.radius = radius;
+    body.layer = layer;
+    body.mask = mask;
+    body.data = data;
+    // Generation 0 is never handed out, so empty handles never resolve
+    body.generation++;
+    body.active = true;
+    GetCells(position, radius, body.cell);
+    InsertBody(index);
+
+    return BodyHandle(index, body.generation);
+}
+
+
+void CollisionWorld::RemoveBody(BodyHandle body){
+
+    if (!GetBody(body)){
+        return;
+    }
+    EraseBody(body.GetIndex());
+    body_[body.GetIndex()].active = false;
+    free_body_.push_back(body.GetIndex());
+}
+
+
+void CollisionWorld::MoveBody(BodyHandle body, const glm::vec3 &position){
+
+    if (!GetBody(body)){
+        return;
+    }
+    CollisionBody &moved = body_[body.GetIndex()];
+    moved.position = position;
+
+    int cell[4];
+    GetCells(position, moved.radius, cell);
+    if ((cell[0] != moved.cell[0]) || (cell[1] != moved.cell[1]) ||
+        (cell[2] != moved.cell[2]) || (cell[3] != moved.cell[3])){
+        EraseBody(body.GetIndex());
+        std::copy(cell, cell + 4, moved.cell);
+        InsertBody(body.GetIndex());
+    }
+}
+
+
+const CollisionBody *CollisionWorld::GetBody(BodyHandle body) const {
+
+    if (body.GetIndex() >= body_.size()){
+        return NULL;
+    }
+    const CollisionBody &found = body_[body.GetIndex()];
+    if (!found.active || (found.generation != body.GetGeneration())){
+        return NULL;
+    }
+    return &found;
+}
+
+
+int CollisionWorld::Overlap(const glm::vec3 &center, float radius, unsigned int mask, std::vector<BodyHandle> &result) const {
+
+    int cell[4];
+    GetCells(center, radius, cell);
+    int count = 0;
+    for (int x = cell[0]; x <= cell[2]; x++){
+        for (int z = cell[1]; z <= cell[3]; z++){
+            std::unordered_map<uint64_t, std::vector<unsigned int> >::const_iterator it = cell_.find(CellKey(x, z));
+            if (it == cell_.end()){
+                continue;
+            }
+            for (unsigned int i = 0; i < it->second.size(); i++){
+                const CollisionBody &body = body_[it->second[i]];
+                if (!(body.layer & mask)){
+                    continue;
+                }
+                // A body in several of the cells is tested in the first
+                // cell it shares with the query only
+                if ((x != std::max(cell[0], body.cell[0])) || (z != std::max(cell[1], body.cell[1]))){
+                    continue;
+                }
+                float distance = radius + body.radius;
+                glm::vec3 offset = body.position - center;
+                if (glm::dot(offset, offset) <= distance * distance){
+                    result.push_back(BodyHandle(it->second[i], body.generation));
+                    count++;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+
+bool CollisionWorld::Raycast(const glm::vec3 &origin, const glm::vec3 &direction, float max_distance, unsigned int mask, RayHit &hit) const {
+
+    hit.body = BodyHandle();
+    hit.distance = max_distance;
+
+    // Walk the cells crossed by the ray on the XZ plane, nearest first
+    int x = (int) floor(origin.x / cell_size_);
+    int z = (int) floor(origin.z / cell_size_);
+    int step_x = (direction.x > 0.0f) ? 1 : -1;
+    int step_z = (direction.z > 0.0f) ? 1 : -1;
+    // Distance along the ray to the next cell boundary on each axis, and
+    // between boundaries
+    float next_x = INFINITY, delta_x = INFINITY;
+    if (direction.x != 0.0f){
+        float boundary = (x + (step_x > 0 ? 1 : 0)) * cell_size_;
+        next_x = (boundary - origin.x) / direction.x;
+        delta_x = cell_size_ / fabs(direction.x);
+    }
+    float next_z = INFINITY, delta_z = INFINITY;
+    if (direction.z != 0.0f){
+        float boundary = (z + (step_z > 0 ? 1 : 0)) * cell_size_;
+        next_z = (boundary - origin.z) / direction.z;
+        delta_z = cell_size_ / fabs(direction.z);
+    }
+
+    while (true){
+        std::unordered_map<uint64_t, std::vector<unsigned int> >::const_iterator it = cell_.find(CellKey(x, z));
+        if (it != cell_.end()){
+            for (unsigned int i = 0; i < it->second.size(); i++){
+                if (body_[it->second[i]].layer & mask){
+                    TestRay(it->second[i], origin, direction, hit);
+                }
+            }
+        }
+
+        // A body is in every cell its sphere touches, so a hit before the
+        // ray leaves this cell cannot be beaten by bodies further on
+        float exit = std::min(next_x, next_z);
+        if (exit >= hit.distance){
+            break;
+        }
+        if (next_x < next_z){
+            x += step_x;
+            next_x += delta_x;
+        } else {
+            z += step_z;
+            next_z += delta_z;
+        }
+    }
+
+    return hit.body.IsValid();
+}
+
+
+bool CollisionWorld::Sweep(const SweepQuery &query, SweepHit &hit) const {
+
+    hit.body = BodyHandle();
+    hit.time = 1.0f;
+
+    // Candidates: the bodies in the cells covered by the swept sphere,
+    // each once
+    glm::vec3 end = query.start + query.displacement;
+    int cell[4];
+    GetCells(query.start, query.radius, cell);
+    int end_cell[4];
+    GetCells(end, query.radius, end_cell);
+    cell[0] = std::min(cell[0], end_cell[0]);
+    cell[1] = std::min(cell[1], end_cell[1]);
+    cell[2] = std::max(cell[2], end_cell[2]);
+    cell[3] = std::max(cell[3], end_cell[3]);
+    sweep_index_.clear();
+    sweep_x_.clear();
+    sweep_y_.clear();
+    sweep_z_.clear();
+    sweep_radius_.clear();
+    for (int x = cell[0]; x <= cell[2]; x++){
+        for (int z = cell[1]; z <= cell[3]; z++){
+            std::unordered_map<uint64_t, std::vector<unsigned int> >::const_iterator it = cell_.find(CellKey(x, z));
+            if (it == cell_.end()){
+                continue;
+            }
+            for (unsigned int i = 0; i < it->second.size(); i++){
+                const CollisionBody &body = body_[it->second[i]];
+                if (!(body.layer & query.mask) ||
+                    (x != std::max(cell[0], body.cell[0])) || (z != std::max(cell[1], body.cell[1]))){
+                    continue;
+                }
+                sweep_index_.push_back(it->second[i]);
+                sweep_x_.push_back(body.position.x);
+                sweep_y_.push_back(body.position.y);
+                sweep_z_.push_back(body.position.z);
+                sweep_radius_.push_back(body.radius);
+            }
+        }
+    }
+    int count = sweep_index_.size();
+    if (count == 0){
+        return false;
+    }
+
+    // Solve |start + t * displacement - center| = radius + body radius
+    // for the first t, for all candidates. Misses get a time past the
+    // tick. The loop has no branches, so the compiler runs it on several
+    // candidates at a time (GCC and Clang need -fno-math-errno
+    // -fno-trapping-math to if-convert the sqrt and the compares)
+    sweep_time_.resize(count);
+    const float *cx = &sweep_x_[0];
+    const float *cy = &sweep_y_[0];
+    const float *cz = &sweep_z_[0];
+    const float *cr = &sweep_radius_[0];
+    float *time = &sweep_time_[0];
+    float dx = query.displacement.x, dy = query.displacement.y, dz = query.displacement.z;
+    float a = std::max(dx * dx + dy * dy + dz * dz, 1e-12f);
+    bool overlaps = query.overlaps;
+    for (int i = 0; i < count; i++){
+        float ox = query.start.x - cx[i];
+        float oy = query.start.y - cy[i];
+        float oz = query.start.z - cz[i];
+        float r = query.radius + cr[i];
+        float b = ox * dx + oy * dy + oz * dz;
+        float c = ox * ox + oy * oy + oz * oz - r * r;
+        float discriminant = b * b - a * c;
+        float t = (-b - std::sqrt(std::max(discriminant, 0.0f))) / a;
+        // Spheres overlapping at the start hit at once, whatever the
+        // displacement, if the query wants them; others only while
+        // approaching ('&' and '|' rather than '&&' and '||' keep the loop
+        // free of branches)
+        bool inside = c <= 0.0f;
+        bool hit = (inside & overlaps) | (!inside & (b < 0.0f) & (discriminant >= 0.0f) & (t <= 1.0f));
+        time[i] = hit ? (inside ? 0.0f : t) : 2.0f;
+    }
+
+    int best = 0;
+    for (int i = 1; i < count; i++){
+        if (time[i] < time[best]){
+            best = i;
+        }
+    }
+    if (time[best] > 1.0f){
+        return false;
+    }
+
+    const CollisionBody &body = body_[sweep_index_[best]];
+    glm::vec3 center = query.start + query.displacement * time[best];
+    glm::vec3 offset = center - body.position;
+    float length = glm::length(offset);
+    hit.body = BodyHandle(sweep_index_[best], body.generation);
+    hit.time = time[best];
+    hit.normal = (length > 0.0f) ? offset / length : glm::vec3(0.0, 1.0, 0.0);
+    hit.point = body.position + hit.normal * body.radius;
+    return true;
+}
+
+
+int CollisionWorld::SweepBatch(const SweepQuery *query, int count, SweepHit *hit) const {
+
+    int hit_num = 0;
+    for (int i = 0; i < count; i++){
+        if (Sweep(query[i], hit[i])){
+            hit_num++;
+        }
+    }
+    return hit_num;
+}
+
+
+void CollisionWorld::Step(void){
+
+    contact_.clear();
+    pair_tests_ = 0;
+
+    for (unsigned int a = 0; a < body_.size(); a++){
+        const CollisionBody &body = body_[a];
+        if (!body.active || !body.mask){
+            continue;
+        }
+        for (int x = body.cell[0]; x <= body.cell[2]; x++){
+            for (int z = body.cell[1]; z <= body.cell[3]; z++){
+                const std::vector<unsigned int> &cell = cell_[CellKey(x, z)];
+                for (unsigned int i = 0; i < cell.size(); i++){
+                    unsigned int b = cell[i];
+                    const CollisionBody &other = body_[b];
+                    if ((b == a) || !(body.mask & other.layer)){
+                        continue;
+                    }
+                    // Bodies looking for each other report one contact
+                    if ((b < a) && (other.mask & body.layer)){
+                        continue;
+                    }
+                    // Pairs sharing several cells are tested in the first
+                    if ((x != std::max(body.cell[0], other.cell[0])) || (z != std::max(body.cell[1], other.cell[1]))){
+                        continue;
+                    }
+
+                    pair_tests_++;
+                    glm::vec3 offset = other.position - body.position;
+                    float distance = body.radius + other.radius;
+                    float length2 = glm::dot(offset, offset);
+                    if (length2 > distance * distance){
+                        continue;
+                    }
+                    float length = sqrt(length2);
+                    Contact contact;
+                    contact.body = BodyHandle(a, body.generation);
+                    contact.other = BodyHandle(b, other.generation);
+                    contact.normal = (length > 0.0f) ? offset / length : glm::vec3(0.0, 1.0, 0.0);
+                    contact.depth = distance - length;
+                    contact.point = body.position + contact.normal * (body.radius - 0.5f * contact.depth);
+                    contact_.push_back(contact);
+                }
+            }
+        }
+    }
+}
+
+
+const std::vector<Contact> &CollisionWorld::GetContacts(void) const {
+
+    return contact_;
+}
+
+
+int CollisionWorld::GetPairTests(void) const {
+
+    return pair_tests_;
+}
+
+
+void CollisionWorld::GetCells(const glm::vec3 &center, float radius, int *cell) const {
+
+    cell[0] = (int) floor((center.x - radius) / cell_size_);
+    cell[1] = (int) floor((center.z - radius) / cell_size_);
+    cell[2] = (int) floor((center.x + radius) / cell_size_);
+    cell[3] = (int) floor((center.z + radius) / cell_size_);
+}
+
+
+uint64_t CollisionWorld::CellKey(int x, int z){
+
+    return ((uint64_t) (uint32_t) x << 32) | (uint32_t) z;
+}
+
+
+void CollisionWorld::InsertBody(unsigned int index){
+
+    const CollisionBody &body = body_[index];
+    for (int x = body.cell[0]; x <= body.cell[2]; x++){
+        for (int z = body.cell[1]; z <= body.cell[3]; z++){
+            cell_[CellKey(x, z)].push_back(index);
+        }
+    }
+}
+
+
+void CollisionWorld::EraseBody(unsigned int index){
+
+    // Cells keep their storage when they empty, since bodies keep coming
+    // back to the same area
+    const CollisionBody &body = body_[index];
+    for (int x = body.cell[0]; x <= body.cell[2]; x++){
+        for (int z = body.cell[1]; z <= body.cell[3]; z++){
+            std::vector<unsigned int> &cell = cell_[CellKey(x, z)];
+            std::vector<unsigned int>::iterator it = std::find(cell.begin(), cell.end(), index);
+            if (it != cell.end()){
+                *it = cell.back();
+                cell.pop_back();
+            }
+        }
+    }
+}
+
+
+void CollisionWorld::TestRay(unsigned int index, const glm::vec3 &origin, const glm::vec3 &direction, RayHit &hit) const {
+
+    const CollisionBody &body = body_[index];
+    glm::vec3 offset = origin - body.position;
+    float b = glm::dot(offset, direction);
+    float c = glm::dot(offset, offset) - body.radius * body.radius;
+    // Outside the sphere and moving away from it
+    if ((c > 0.0f) && (b > 0.0f)){
+        return;
+    }
+    float discriminant = b * b - c;
+    if (discriminant < 0.0f){
+        return;
+    }
+    // A ray starting inside the sphere hits it at once
+    float distance = std::max(-b - (float) sqrt(discriminant), 0.0f);
+    if (distance < hit.distance){
+        hit.body = BodyHandle(index, body.generation);
+        hit.distance = distance;
+        hit.point = origin + direction * distance;
+    }
+}
+
+} // namespace game
@@ -0,0 +1,142 @@
+#ifndef COLLISION_WORLD_H_
+#define COLLISION_WORLD_H_
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "handle.h"
+
+// Side of the cells of the collision grid; a few times the radius of the
+// usual bodies, so most bodies lie in one to four cells
+#define COLLISION_CELL_SIZE 8.0f
+
+namespace game {
+
+    struct CollisionBody;
+    typedef Handle<CollisionBody> BodyHandle;
+
+    // A sphere registered with the collision world
+    // Bodies are found by the bodies whose mask has a bit of their layer
+    struct CollisionBody {
+        glm::vec3 position;
+        float radius;
+        unsigned int layer;
+        unsigned int mask;
+        int data; // Left to the owner, e.g. an instance index
+        int cell[4]; // Cells covered on the grid: min x, min z, max x, max z
+        unsigned int generation;
+        bool active;
+    };
+
+    // Overlap of two bodies found by Step(); 'normal' points from 'body'
+    // to 'other', the body 'body' was looking for
+    struct Contact {
+        BodyHandle body;
+        BodyHandle other;
+        glm::vec3 point;
+        glm::vec3 normal;
+        float depth;
+    };
+
+    // Nearest body along a ray
+    struct RayHit {
+        BodyHandle body;
+        float distance;
+        glm::vec3 point;
+    };
+
+    // A sphere moving by 'displacement' over one tick, e.g. a projectile
+    struct SweepQuery {
+        glm::vec3 start;
+        glm::vec3 displacement;
+        float radius;
+        unsigned int mask;
+        // Whether bodies the sphere overlaps at the start hit it at time
+        // 0; if not, they are left out and the sweep finds the next body
+        bool overlaps;
+    };
+
+    // First body touched by a moving sphere; 'time' is the fraction of
+    // the displacement done at the impact, from 0 to 1
+    struct SweepHit {
+        BodyHandle body;
+        float time;
+        glm::vec3 point;
+        glm::vec3 normal; // From the body to the moving sphere
+    };
+
+    // Spheres hashed on a uniform grid over the XZ plane
+    // Queries and contacts only test the bodies sharing cells with the
+    // query, so their cost follows the number of nearby bodies instead of
+    // the number of bodies in the world
+    class CollisionWorld {
+
+        public:
+            // Constructor and destructor
+            CollisionWorld(float cell_size = COLLISION_CELL_SIZE);
+            ~CollisionWorld();
+
+            // Add a sphere of layer 'layer' that collides with the layers
+            // in 'mask'; a mask of 0 is for bodies that are only found
+            BodyHandle AddBody(const glm::vec3 &position, float radius, unsigned int layer, unsigned int mask, int data = 0);
+            void RemoveBody(BodyHandle body);
+            // Move a body; it is only rehashed when it changes cells
+            void MoveBody(BodyHandle body, const glm::vec3 &position);
+            // Resolve a handle, or NULL if the body was removed
+            const CollisionBody *GetBody(BodyHandle body) const;
+
+            // Bodies of the layers in 'mask' that overlap a sphere;
+            // returns their number
+            int Overlap(const glm::vec3 &center, float radius, unsigned int mask, std::vector<BodyHandle> &result) const;
+            // Nearest body of the layers in 'mask' hit by a ray within
+            // 'max_distance', which must be finite; 'direction' must be
+            // normalized
+            bool Raycast(const glm::vec3 &origin, const glm::vec3 &direction, float max_distance, unsigned int mask, RayHit &hit) const;
+            // Time of impact of a moving sphere over the whole tick, so
+            // bodies faster than their targets cannot pass through them
+            // A sphere already overlapping a body hits it at time 0, unless
+            // the query leaves overlaps out
+            bool Sweep(const SweepQuery &query, SweepHit &hit) const;
+            // Sweep many spheres at once; 'hit[i].body' is empty for the
+            // queries that hit nothing. Returns the number of hits
+            int SweepBatch(const SweepQuery *query, int count, SweepHit *hit) const;
+
+            // Find the contacts of this tick, replacing the last ones
+            void Step(void);
+            const std::vector<Contact> &GetContacts(void) const;
+            // Number of sphere tests made by the last step
+            int GetPairTests(void) const;
+
+        private:
+            float cell_size_;
+            // Bodies, in slots reused after removal
+            std::vector<CollisionBody> body_;
+            std::vector<unsigned int> free_body_;
+            // Bodies overlapping each cell, keyed by the cell coordinates
+            std::unordered_map<uint64_t, std::vector<unsigned int> > cell_;
+            std::vector<Contact> contact_;
+            int pair_tests_;
+            // Candidates of a sweep, gathered as arrays so the time of
+            // impact is computed over all of them in one vectorizable loop
+            mutable std::vector<unsigned int> sweep_index_;
+            mutable std::vector<float> sweep_x_;
+            mutable std::vector<float> sweep_y_;
+            mutable std::vector<float> sweep_z_;
+            mutable std::vector<float> sweep_radius_;
+            mutable std::vector<float> sweep_time_;
+
+            // Cells covered by a sphere
+            void GetCells(const glm::vec3 &center, float radius, int *cell) const;
+            static uint64_t CellKey(int x, int z);
+            void InsertBody(unsigned int index);
+            void EraseBody(unsigned int index);
+            // Body tested against a ray; updates 'hit' if it is nearer
+            void TestRay(unsigned int index, const glm::vec3 &origin, const glm::vec3 &direction, RayHit &hit) const;
+
+    }; // class CollisionWorld
+
+} // namespace game
+
+#endif // COLLISION_WORLD_H_
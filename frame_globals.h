@@ -0,0 +1,29 @@
+#ifndef FRAME_GLOBALS_H_
+#define FRAME_GLOBALS_H_
+
+#include <glm/glm.hpp>
+
+// Name of the uniform block holding the per-frame constants in the shaders
+#define FRAME_GLOBALS_BLOCK "FrameGlobals"
+// Uniform buffer binding point of the block, the same in every program
+#define FRAME_GLOBALS_BINDING 0
+// Number of lights in the scene
+#define NUM_LIGHTS 2
+
+namespace game {
+
+    // Shader constants shared by all programs, written once per frame
+    // Matches the std140 layout of the FrameGlobals block: every member
+    // is a mat4 or vec4, so no padding is needed
+    struct FrameGlobals {
+        glm::mat4 view_mat;
+        glm::mat4 projection_mat;
+        glm::vec4 camera_position; // xyz: world position of the camera
+        glm::vec4 light_position[NUM_LIGHTS]; // xyz: world position of each light
+        glm::vec4 material_light_position[NUM_LIGHTS]; // Lights of the materials lit from their own positions
+        glm::vec4 timer; // x: time in seconds
+    };
+
+} // namespace game
+
+#endif // FRAME_GLOBALS_H_
@@ -21,6 +21,10 @@ float camera_near_clip_distance_g = 0.01;
 float camera_far_clip_distance_g = 1000.0;
 float camera_fov_g = 25.0; // Field-of-view of camera
 const glm::vec3 viewport_background_color_g(0.3, 0.1, 0.1);
+const glm::vec3 light_position_g[NUM_LIGHTS] = {glm::vec3(-0.5, 10.0, 1.5), glm::vec3(4.0, 10.0, -1.0)};
+// Lights the metal, plastic, toon, shiny blue and plain textured materials
+// were made with
+const glm::vec3 material_light_position_g[NUM_LIGHTS] = {glm::vec3(-0.5, -0.5, 1.5), glm::vec3(4.0, -1.0, -1.0)};
 glm::vec3 camera_position_g(0.5, 0.5, 10.0);
 glm::vec3 camera_look_at_g(0.0, 0.0, 0.0);
 glm::vec3 camera_up_g(0.0, 1.0, 0.0);
@@ -28,6 +32,24 @@ glm::vec3 camera_up_g(0.0, 1.0, 0.0);
 // Materials 
 const std::string material_directory_g = MATERIAL_DIRECTORY;
 
+// Time per frame given to creating resources loaded in the background
+const double upload_time_budget_g = 0.002;
+
+// Seconds between two refreshes of the statistics in the window title
+const double title_interval_g = 1.0;
+
+// Radius of the collision spheres of the player and of asteroids
+const float player_radius_g = 0.7;
+const float asteroid_radius_g = 1.0;
+
+// Projectiles: pool size, radius, speed and life in ticks, and ticks
+// between two shots of the player
+const int projectile_capacity_g = 1024;
+const float projectile_radius_g = 0.1;
+const float projectile_speed_g = 1.0;
+const int projectile_life_g = 300;
+const int fire_interval_g = 5;
+
 
 Game::Game(void){
 
@@ -44,6 +66,10 @@ void Game::Init(void){
 
     // Set variables
     animating_ = true;
+    projectiles_ = NULL;
+    fire_cooldown_ = 0;
+    title_time_ = 0.0;
+    asteroid_field_ = NULL;
 	std::string keymap[] = { "w", "a", "s", "d", " ", "lshift", "lctrl" , "left", "right"};
 	for (int i = 0; i < sizeof(keymap) / sizeof(*keymap); i++) {
 		keys.insert(std::pair<std::string, bool> (keymap[i], false));
@@ -114,49 +140,14 @@ void Game::InitEventHandlers(void){
 
 void Game::SetupResources(void){
 
-    // Create a torus
-    resman_.CreateTorus("TorusMesh");
-	resman_.CreateCylinder("CylinderMesh");
-
-    // Load material to be applied to torus
-    //std::string filename = std::string(MATERIAL_DIRECTORY) + std::string("/three-term_shiny_blue");
-	std::string filename = std::string(MATERIAL_DIRECTORY) + std::string("/three-term_textured");
-    resman_.LoadResource(Material, "3TTexturedMaterial", filename.c_str());
-
-	filename = std::string(MATERIAL_DIRECTORY) + std::string("/metal");
-	resman_.LoadResource(Material, "ShinyBlueMetal", filename.c_str());
-
-	filename = std::string(MATERIAL_DIRECTORY) + std::string("/plastic");
-	resman_.LoadResource(Material, "PlasticMaterial", filename.c_str());
-
-	filename = std::string(MATERIAL_DIRECTORY) + std::string("/three-term_toon");
-	resman_.LoadResource(Material, "ToonMaterial", filename.c_str());
-
-    // Load a cube from an obj file
-    filename = std::string(MATERIAL_DIRECTORY) + std::string("/cube.obj");
-    resman_.LoadResource(Mesh, "CubeMesh", filename.c_str());
-
-    // Load texture to be applied to the cube
-    filename = std::string(MATERIAL_DIRECTORY) + std::string("/randomspace.png");
-    resman_.LoadResource(Texture, "Space", filename.c_str());
-
-	// Load texture to be applied to the cube
-	filename = std::string(MATERIAL_DIRECTORY) + std::string("/crumpled.png");
-	resman_.LoadResource(Texture, "Crumpled", filename.c_str());
-
-	// Load texture to be applied to the cube
-	filename = std::string(MATERIAL_DIRECTORY) + std::string("/checker.png");
-	resman_.LoadResource(Texture, "Checker", filename.c_str());
-
-    // Load material to be applied to the cube
-    filename = std::string(MATERIAL_DIRECTORY) + std::string("/textured_material");
-    resman_.LoadResource(Material, "TexturedMaterial", filename.c_str());
-
-	// Load plane mesh
-	resman_.CreatePlane("PlaneMesh", glm::vec3(1.0, 1.0, 1.0));
+    // Keep processed meshes and linked shader programs between runs
+    resman_.SetMeshCacheDirectory(material_directory_g + std::string("/cache"));
+    resman_.SetProgramCacheDirectory(material_directory_g + std::string("/cache"));
 
-	// Load sphere mesh
-	resman_.CreateSphere("SimpleSphereMesh", 1, 20, 20);
+    // Everything else is listed in the manifest; unused lazy items cost
+    // nothing, and files load in parallel while the scene is set up
+    std::string filename = material_directory_g + std::string("/resources.manifest");
+    resman_.LoadManifest(filename.c_str());
 }
 
 
@@ -164,32 +155,46 @@ void Game::SetupScene(void){
 
     // Set background color for the scene
     scene_.SetBackgroundColor(viewport_background_color_g);
-	//CreateAsteroidField();
+
+    // Set the lights shared by all materials
+    for (int i = 0; i < NUM_LIGHTS; i++){
+        scene_.SetLightPosition(i, light_position_g[i]);
+        scene_.SetMaterialLightPosition(i, material_light_position_g[i]);
+    }
+
+    // Asteroids to fly around and shoot; each has a collision body
+    CreateAsteroidField();
+
+	// Resources shared by the parts of the turret, resolved once
+	MeshHandle cylinder = GetMeshHandle("CylinderMesh");
+	MaterialHandle textured = GetMaterialHandle("3TTexturedMaterial");
+	TextureHandle crumpled = GetTextureHandle("Crumpled");
 
     // Create a turret
 	// base
-	game::Helicopter *chopperbase = CreateHelicopter("HelicopterBase", "CylinderMesh", "3TTexturedMaterial", "Crumpled");
+	game::Helicopter *chopperbase = CreateHelicopter("HelicopterBase", cylinder, textured, crumpled);
     // Adjust the instance
 	chopperbase->Translate(glm::vec3(1.4, 2.0, 0.0));
 	chopperbase->Rotate(glm::angleAxis(-glm::pi<float>() / 180.0f * 90.0f, glm::vec3(1.0, 0.0, 0.0)));
     chopperbase->Scale(glm::vec3(0.5, 0.7, 0.5));
 	player_ = chopperbase;
+	player_body_ = collision_.AddBody(player_->GetPosition(), player_radius_g, CollisionPlayer, CollisionAsteroid);
 
 	// rotating base
-	game::SceneNode *gunbase = CreateInstance("CylinderInstance2", "CylinderMesh", "3TTexturedMaterial", "Crumpled");
+	game::SceneNode *gunbase = CreateInstance("CylinderInstance2", cylinder, textured, crumpled);
 	// Adjust the instance
 	gunbase->Scale(glm::vec3(0.7, 0.4, 0.7));
 	gunbase->Translate(glm::vec3(0.0, 0.3, 0.0));
 	gunbase->Rotate(glm::angleAxis(glm::pi<float>() / 180.0f * 45.0f, glm::vec3(0.0, 1.0, 0.0)));
 
 	// first part of gun
-	game::SceneNode *gunback = CreateInstance("CylinderInstance3", "CylinderMesh", "3TTexturedMaterial", "Crumpled");
+	game::SceneNode *gunback = CreateInstance("CylinderInstance3", cylinder, textured, crumpled);
 	// Adjust the instance
 	gunback->Scale(glm::vec3(0.1, 0.5, 0.1));
 	gunback->SetOrbit(glm::vec3(0.0, 0.5, 0.0));
 
 	// second part of gun
-	game::SceneNode *gunfront = CreateInstance("CylinderInstance4", "CylinderMesh", "3TTexturedMaterial", "Space");
+	game::SceneNode *gunfront = CreateInstance("CylinderInstance4", cylinder, textured, GetTextureHandle("Space"));
 	// Adjust the instance
 	gunfront->Scale(glm::vec3(0.075, 0.5, 0.075));
 	chopperbase->AddNode(gunbase);
@@ -197,11 +202,19 @@ void Game::SetupScene(void){
 	gunback->AddNode(gunfront);
 
 	// Ground Plane
-	game::SceneNode *plane = CreateInstance("PlaneInstance1", "PlaneMesh", "3TTexturedMaterial", "Crumpled");
+	game::SceneNode *plane = CreateInstance("PlaneInstance1", GetMeshHandle("PlaneMesh"), textured, crumpled);
 	// Adjust the instance
 	plane->Scale(glm::vec3(50.0, 50.0, 50.0));
 	plane->Rotate(glm::angleAxis(glm::pi<float>() / 180.0f * 90.0f, glm::vec3(1.0, 0.0, 0.0)));
 
+	// Projectiles, spheres sharing the asteroids' instanced material
+	projectiles_ = CreateProjectileSystem("Projectiles", GetMeshHandle("SimpleSphereMesh"), GetMaterialHandle("ShinyBlueInstancedMaterial"), TextureHandle(), projectile_capacity_g, projectile_radius_g);
+
+	// Cache handles to the nodes animated in the main loop
+	chopper_base_ = scene_.GetHandle<Helicopter>("HelicopterBase");
+	gun_base_ = scene_.GetHandle<SceneNode>("CylinderInstance2");
+	gun_back_ = scene_.GetHandle<SceneNode>("CylinderInstance3");
+	gun_front_ = scene_.GetHandle<SceneNode>("CylinderInstance4");
 	
 }
 
@@ -247,20 +260,30 @@ void Game::MainLoop(void){
 				if (keys.at("lshift")) {
 					player_->ApplyForce(player_->GetForward()*(0.001f));
 				}
-				SceneNode *node = scene_.GetNode("HelicopterBase");
+				// Full-auto fire along the nose of the helicopter
+				if (fire_cooldown_ > 0) {
+					fire_cooldown_--;
+				}
+				if (keys.at("lctrl") && (fire_cooldown_ == 0)) {
+					glm::vec3 direction = player_->GetUp();
+					projectiles_->Fire(player_->GetPosition() + direction*player_radius_g, direction*projectile_speed_g, projectile_life_g, 0, CollisionAsteroid);
+					fire_cooldown_ = fire_interval_g;
+				}
+				HandleCollisions();
+				SceneNode *node = scene_.GetNode(chopper_base_);
 				camera_.SetPosition(node->GetPosition() - node->GetUp()*5.0f - node->GetForward()*1.0f); //
 				camera_.SetView(camera_.GetPosition(), node->GetPosition(), glm::vec3(0.0, 1.0, 0.0));
 
-                node = scene_.GetNode("CylinderInstance2");
+                node = scene_.GetNode(gun_base_);
 				glm::quat rotation = glm::angleAxis(glm::pi<float>() / 180.0f / 2.0f, glm::vec3(0.0, 1.0, 0.0));
 				node->Rotate(rotation);
 				
 
-				node = scene_.GetNode("CylinderInstance3");
+				node = scene_.GetNode(gun_back_);
 				node->SetOrientation(glm::angleAxis(glm::pi<float>() / 180.0f * (90.0f + (float)cos(glfwGetTime()*5.0f)*20.0f), glm::vec3(0.0, 0.0, 1.0)));
 				
 
-				node = scene_.GetNode("CylinderInstance4");
+				node = scene_.GetNode(gun_front_);
 				node->SetPosition(glm::vec3(0.0, 0.25 + sin(glfwGetTime()*20.0f)*0.125, 0.0));
 
 				
@@ -273,8 +296,27 @@ void Game::MainLoop(void){
 			
 		}
 
+        // Create the resources finished by the loader threads, a few
+        // per frame
+        resman_.ProcessUploads(upload_time_budget_g);
+        // Free unloaded resources the scene stopped using
+        resman_.Purge();
+
         // Draw the scene
         scene_.Draw(&camera_);
+        // Delete the nodes destroyed during the frame
+        scene_.FlushDestroyed();
+
+        // Report culling statistics of the frame; setting the title goes
+        // to the window system, so only now and then
+        double title_time = glfwGetTime();
+        if ((title_time - title_time_) >= title_interval_g){
+            std::ostringstream title;
+            title << window_title_g << " - drawn: " << scene_.GetVisibleCount() << ", culled: " << scene_.GetCulledCount();
+            title << ", resources: " << resman_.GetResidentBytes() / (1024 * 1024) << " MB";
+            glfwSetWindowTitle(window_, title.str().c_str());
+            title_time_ = title_time;
+        }
 
         // Push buffer drawn in the background onto the display
         glfwSwapBuffers(window_);
@@ -341,6 +383,9 @@ void Game::KeyCallback(GLFWwindow* window, int key, int scancode, int action, in
 		if (key == GLFW_KEY_LEFT_SHIFT) {
 			game->keys.at("lshift") = true;
 		}
+		if (key == GLFW_KEY_LEFT_CONTROL) {
+			game->keys.at("lctrl") = true;
+		}
 	}
 	else if (action == GLFW_RELEASE) {
 		if (key == GLFW_KEY_W) {
@@ -361,6 +406,9 @@ void Game::KeyCallback(GLFWwindow* window, int key, int scancode, int action, in
 		if (key == GLFW_KEY_LEFT_SHIFT) {
 			game->keys.at("lshift") = false;
 		}
+		if (key == GLFW_KEY_LEFT_CONTROL) {
+			game->keys.at("lctrl") = false;
+		}
 		if (key == GLFW_KEY_LEFT) {
 			game->keys.at("left") = false;
 		}
@@ -389,32 +437,70 @@ void Game::ResizeCallback(GLFWwindow* window, int width, int height){
 }
 
 
+void Game::HandleCollisions(void){
+
+    // Sweep the player from where its body was, so a fast move cannot
+    // skip over an asteroid; asteroids it starts in are left out of the
+    // sweep and pushed apart by the contacts below
+    const CollisionBody *body = collision_.GetBody(player_body_);
+    SweepQuery query;
+    query.start = body->position;
+    query.displacement = player_->GetPosition() - body->position;
+    query.radius = body->radius;
+    query.mask = body->mask;
+    query.overlaps = false;
+    SweepHit hit;
+    if (collision_.Sweep(query, hit)){
+        player_->SetPosition(query.start + query.displacement * hit.time);
+    }
+
+    collision_.MoveBody(player_body_, player_->GetPosition());
+    collision_.Step();
+
+    const std::vector<Contact> &contact = collision_.GetContacts();
+    for (unsigned int i = 0; i < contact.size(); i++){
+        if (contact[i].body.GetIndex() == player_body_.GetIndex()){
+            player_->Translate(-contact[i].normal * contact[i].depth);
+            collision_.MoveBody(player_body_, player_->GetPosition());
+        }
+    }
+
+    // Asteroids hit by projectiles in the last update disappear
+    const std::vector<ProjectileHit> &shot = projectiles_->GetHits();
+    for (unsigned int i = 0; i < shot.size(); i++){
+        const CollisionBody *target = collision_.GetBody(shot[i].body);
+        if (!target){
+            continue;
+        }
+        if ((target->layer == CollisionAsteroid) && asteroid_field_){
+            asteroid_field_->SetInstanceScale(target->data, glm::vec3(0.0, 0.0, 0.0));
+        }
+        collision_.RemoveBody(shot[i].body);
+    }
+}
+
+
 Game::~Game(){
-    
+
+    // Delete the nodes while their resources and the context still exist
+    if (!scene_.Clear()){
+        std::cerr << "Scene nodes outside the scene graph were not deleted" << std::endl;
+    }
     glfwTerminate();
 }
 
 
 Asteroid *Game::CreateAsteroidInstance(std::string entity_name, std::string object_name, std::string material_name, std::string texture_name){
 
-    // Get resources
-    Resource *geom = resman_.GetResource(object_name);
-    if (!geom){
-        throw(GameException(std::string("Could not find resource \"")+object_name+std::string("\"")));
-    }
+    return CreateAsteroidInstance(entity_name, GetMeshHandle(object_name), GetMaterialHandle(material_name), GetTextureHandle(texture_name));
+}
 
-    Resource *mat = resman_.GetResource(material_name);
-    if (!mat){
-        throw(GameException(std::string("Could not find resource \"")+material_name+std::string("\"")));
-    }
 
-	Resource *tex = NULL;
-	if (texture_name != "") {
-		tex = resman_.GetResource(texture_name);
-		if (!mat) {
-			throw(GameException(std::string("Could not find resource \"") + material_name + std::string("\"")));
-		}
-	}
+Asteroid *Game::CreateAsteroidInstance(std::string entity_name, MeshHandle object, MaterialHandle material, TextureHandle texture){
+
+    // Get resources
+    Resource *geom, *mat, *tex;
+    GetResources(object, material, texture, geom, mat, tex);
 
     // Create asteroid instance
     Asteroid *ast = new Asteroid(entity_name, geom, mat, tex);
@@ -425,73 +511,141 @@ Asteroid *Game::CreateAsteroidInstance(std::string entity_name, std::string obje
 
 void Game::CreateAsteroidField(int num_asteroids){
 
+    // All asteroids share mesh, material and texture, so draw them as one
+    // instanced batch
+    InstancedNode *field = CreateInstancedNode("AsteroidField", "SimpleSphereMesh", "ShinyBlueInstancedMaterial", "Checker");
+    asteroid_field_ = field;
+
     // Create a number of asteroid instances
     for (int i = 0; i < num_asteroids; i++){
-        // Create instance name
-        std::stringstream ss;
-        ss << i;
-        std::string index = ss.str();
-        std::string name = "AsteroidInstance" + index;
-
-        // Create asteroid instance
-        Asteroid *ast = CreateAsteroidInstance(name, "SimpleSphereMesh", "ShinyBlueMaterial", "Checker");
-
         // Set attributes of asteroid: random position, orientation, and
         // angular momentum
-        ast->SetPosition(glm::vec3(-300.0 + 600.0*((float) rand() / RAND_MAX), -300.0 + 600.0*((float) rand() / RAND_MAX), 600.0*((float) rand() / RAND_MAX)));
-        ast->SetOrientation(glm::normalize(glm::angleAxis(glm::pi<float>()*((float) rand() / RAND_MAX), glm::vec3(((float) rand() / RAND_MAX), ((float) rand() / RAND_MAX), ((float) rand() / RAND_MAX)))));
-        ast->SetAngM(glm::normalize(glm::angleAxis(0.05f*glm::pi<float>()*((float) rand() / RAND_MAX), glm::vec3(((float) rand() / RAND_MAX), ((float) rand() / RAND_MAX), ((float) rand() / RAND_MAX)))));
+        glm::vec3 position(-300.0 + 600.0*((float) rand() / RAND_MAX), -300.0 + 600.0*((float) rand() / RAND_MAX), 600.0*((float) rand() / RAND_MAX));
+        glm::quat orientation = glm::normalize(glm::angleAxis(glm::pi<float>()*((float) rand() / RAND_MAX), glm::vec3(((float) rand() / RAND_MAX), ((float) rand() / RAND_MAX), ((float) rand() / RAND_MAX))));
+        int ast = field->AddInstance(position, orientation);
+        collision_.AddBody(position, asteroid_radius_g, CollisionAsteroid, 0, ast);
+        field->SetInstanceSpin(ast, glm::normalize(glm::angleAxis(0.05f*glm::pi<float>()*((float) rand() / RAND_MAX), glm::vec3(((float) rand() / RAND_MAX), ((float) rand() / RAND_MAX), ((float) rand() / RAND_MAX)))));
     }
 }
 
 
 SceneNode *Game::CreateInstance(std::string entity_name, std::string object_name, std::string material_name, std::string texture_name){
 
-    Resource *geom = resman_.GetResource(object_name);
-    if (!geom){
-        throw(GameException(std::string("Could not find resource \"")+object_name+std::string("\"")));
-    }
+    return CreateInstance(entity_name, GetMeshHandle(object_name), GetMaterialHandle(material_name), GetTextureHandle(texture_name));
+}
 
-    Resource *mat = resman_.GetResource(material_name);
-    if (!mat){
-        throw(GameException(std::string("Could not find resource \"")+material_name+std::string("\"")));
-    }
 
-    Resource *tex = NULL;
-    if (texture_name != ""){
-        tex = resman_.GetResource(texture_name);
-        if (!mat){
-            throw(GameException(std::string("Could not find resource \"")+material_name+std::string("\"")));
-        }
-    }
+SceneNode *Game::CreateInstance(std::string entity_name, MeshHandle object, MaterialHandle material, TextureHandle texture){
+
+    Resource *geom, *mat, *tex;
+    GetResources(object, material, texture, geom, mat, tex);
 
     SceneNode *scn = scene_.CreateNode(entity_name, geom, mat, tex);
     return scn;
 }
 
+
+InstancedNode *Game::CreateInstancedNode(std::string entity_name, std::string object_name, std::string material_name, std::string texture_name){
+
+    return CreateInstancedNode(entity_name, GetMeshHandle(object_name), GetMaterialHandle(material_name), GetTextureHandle(texture_name));
+}
+
+
+InstancedNode *Game::CreateInstancedNode(std::string entity_name, MeshHandle object, MaterialHandle material, TextureHandle texture){
+
+    Resource *geom, *mat, *tex;
+    GetResources(object, material, texture, geom, mat, tex);
+
+    InstancedNode *batch = new InstancedNode(entity_name, geom, mat, tex);
+    scene_.AddNode(batch);
+    return batch;
+}
+
+
+ProjectileSystem *Game::CreateProjectileSystem(std::string entity_name, MeshHandle object, MaterialHandle material, TextureHandle texture, int capacity, float radius){
+
+    Resource *geom, *mat, *tex;
+    GetResources(object, material, texture, geom, mat, tex);
+
+    // Projectiles collide with the bodies of the game's world
+    ProjectileSystem *pool = new ProjectileSystem(entity_name, geom, mat, tex, capacity, radius);
+    pool->SetCollisionWorld(&collision_);
+    scene_.AddNode(pool);
+    return pool;
+}
+
+
 Helicopter *Game::CreateHelicopter(std::string entity_name, std::string object_name, std::string material_name, std::string texture_name) {
 
-	Resource *geom = resman_.GetResource(object_name);
-	if (!geom) {
-		throw(GameException(std::string("Could not find resource \"") + object_name + std::string("\"")));
-	}
+	return CreateHelicopter(entity_name, GetMeshHandle(object_name), GetMaterialHandle(material_name), GetTextureHandle(texture_name));
+}
 
-	Resource *mat = resman_.GetResource(material_name);
-	if (!mat) {
-		throw(GameException(std::string("Could not find resource \"") + material_name + std::string("\"")));
-	}
 
-	Resource *tex = NULL;
-	if (texture_name != "") {
-		tex = resman_.GetResource(texture_name);
-		if (!mat) {
-			throw(GameException(std::string("Could not find resource \"") + material_name + std::string("\"")));
-		}
-	}
+Helicopter *Game::CreateHelicopter(std::string entity_name, MeshHandle object, MaterialHandle material, TextureHandle texture) {
+
+	Resource *geom, *mat, *tex;
+	GetResources(object, material, texture, geom, mat, tex);
 
 	Helicopter *scn = new Helicopter(entity_name, geom, mat, tex);
 	scene_.AddNode(scn);
 	return scn;
 }
 
+
+MeshHandle Game::GetMeshHandle(std::string name){
+
+    MeshHandle handle = resman_.GetMeshHandle(name);
+    if (!handle.IsValid()){
+        throw(GameException(std::string("Could not find resource \"")+name+std::string("\"")));
+    }
+    return handle;
+}
+
+
+MaterialHandle Game::GetMaterialHandle(std::string name){
+
+    MaterialHandle handle = resman_.GetMaterialHandle(name);
+    if (!handle.IsValid()){
+        throw(GameException(std::string("Could not find resource \"")+name+std::string("\"")));
+    }
+    return handle;
+}
+
+
+TextureHandle Game::GetTextureHandle(std::string name){
+
+    // No name means no texture
+    if (name == ""){
+        return TextureHandle();
+    }
+    TextureHandle handle = resman_.GetTextureHandle(name);
+    if (!handle.IsValid()){
+        throw(GameException(std::string("Could not find resource \"")+name+std::string("\"")));
+    }
+    return handle;
+}
+
+
+void Game::GetResources(MeshHandle object, MaterialHandle material, TextureHandle texture, Resource *&geom, Resource *&mat, Resource *&tex) const {
+
+    geom = resman_.GetResource(object);
+    if (!geom){
+        throw(GameException(std::string("Invalid mesh handle")));
+    }
+
+    mat = resman_.GetResource(material);
+    if (!mat){
+        throw(GameException(std::string("Invalid material handle")));
+    }
+
+    // An empty texture handle means the node has no texture
+    tex = NULL;
+    if (texture.IsValid()){
+        tex = resman_.GetResource(texture);
+        if (!tex){
+            throw(GameException(std::string("Invalid texture handle")));
+        }
+    }
+}
+
 } // namespace game
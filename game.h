@@ -13,6 +13,9 @@
 #include "camera.h"
 #include "asteroid.h"
 #include "helicopter.h"
+#include "instanced_node.h"
+#include "collision_world.h"
+#include "projectile_system.h"
 
 namespace game {
 
@@ -27,6 +30,9 @@ namespace game {
             virtual ~GameException() throw() {};
     };
 
+    // Collision layers of the bodies of the game
+    typedef enum CollisionLayerType { CollisionPlayer = 1, CollisionAsteroid = 2 } CollisionLayer;
+
     // Game application
     class Game {
 
@@ -57,9 +63,28 @@ namespace game {
 			// Helicopter node for player
 			Helicopter *player_;
 
+			// Nodes animated every tick, resolved once in SetupScene
+			Handle<Helicopter> chopper_base_;
+			Handle<SceneNode> gun_base_;
+			Handle<SceneNode> gun_back_;
+			Handle<SceneNode> gun_front_;
+
             // Resources available to the game
             ResourceManager resman_;
 
+            // Bodies that collide, on a grid so only neighbours are tested
+            CollisionWorld collision_;
+            BodyHandle player_body_;
+
+            // Every projectile in flight, in one pool
+            ProjectileSystem *projectiles_;
+            // Ticks until the player can fire again
+            int fire_cooldown_;
+            // Time the window title was last refreshed
+            double title_time_;
+            // Instanced asteroids, if the field was created
+            InstancedNode *asteroid_field_;
+
             // Camera abstraction
             Camera camera_;
 
@@ -75,16 +100,40 @@ namespace game {
             static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
             static void ResizeCallback(GLFWwindow* window, int width, int height);
 
+            // Move the player's body, stopping the player at the first
+            // thing it hit this tick, and push it out of what it overlaps;
+            // then destroy what the projectiles hit
+            void HandleCollisions(void);
+
             // Asteroid field
             // Create instance of one asteroid
             Asteroid *CreateAsteroidInstance(std::string entity_name, std::string object_name, std::string material_name, std::string texture_name);
-            // Create entire random asteroid field
+            Asteroid *CreateAsteroidInstance(std::string entity_name, MeshHandle object, MaterialHandle material, TextureHandle texture);
+            // Create entire random asteroid field, drawn as one instanced batch
             void CreateAsteroidField(int num_asteroids = 1500);
 
             // Create an instance of an object stored in the resource manager
             SceneNode *CreateInstance(std::string entity_name, std::string object_name, std::string material_name, std::string texture_name = std::string(""));
+            // Same with handles resolved beforehand, so repeated spawns do
+            // not look names up
+            SceneNode *CreateInstance(std::string entity_name, MeshHandle object, MaterialHandle material, TextureHandle texture = TextureHandle());
+            // Create an empty batch of instances of an object
+            InstancedNode *CreateInstancedNode(std::string entity_name, std::string object_name, std::string material_name, std::string texture_name = std::string(""));
+            InstancedNode *CreateInstancedNode(std::string entity_name, MeshHandle object, MaterialHandle material, TextureHandle texture = TextureHandle());
+            // Create the pool of projectiles, drawn as copies of an object
+            ProjectileSystem *CreateProjectileSystem(std::string entity_name, MeshHandle object, MaterialHandle material, TextureHandle texture, int capacity, float radius);
 
 			Helicopter *CreateHelicopter(std::string entity_name, std::string object_name, std::string material_name, std::string texture_name);
+			Helicopter *CreateHelicopter(std::string entity_name, MeshHandle object, MaterialHandle material, TextureHandle texture);
+
+            // Handles of resources by name; throw if a resource is missing
+            // An empty texture name gives an empty handle: no texture
+            MeshHandle GetMeshHandle(std::string name);
+            MaterialHandle GetMaterialHandle(std::string name);
+            TextureHandle GetTextureHandle(std::string name);
+            // Resolve the resources of a new node; throws if a handle is
+            // stale
+            void GetResources(MeshHandle object, MaterialHandle material, TextureHandle texture, Resource *&geom, Resource *&mat, Resource *&tex) const;
 
     }; // class Game
 
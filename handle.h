@@ -0,0 +1,31 @@
+#ifndef HANDLE_H_
+#define HANDLE_H_
+
+namespace game {
+
+    // Weak reference to an object owned by one of the managers
+    // The index selects a slot in the manager and the generation detects
+    // when the slot was reused, so a stale handle resolves to NULL instead
+    // of to an unrelated object
+    template <typename T>
+    class Handle {
+
+        public:
+            // An empty handle never resolves
+            Handle(void) : index_(0), generation_(0) {}
+            Handle(unsigned int index, unsigned int generation) : index_(index), generation_(generation) {}
+
+            unsigned int GetIndex(void) const { return index_; }
+            unsigned int GetGeneration(void) const { return generation_; }
+            // Generation 0 is never handed out by a manager
+            bool IsValid(void) const { return generation_ != 0; }
+
+        private:
+            unsigned int index_;
+            unsigned int generation_;
+
+    }; // class Handle
+
+} // namespace game
+
+#endif // HANDLE_H_
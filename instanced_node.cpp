@@ -0,0 +1,209 @@
+#include <stdexcept>
+#define GLM_FORCE_RADIANS
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "instanced_node.h"
+
+namespace game {
+
+InstancedNode::InstancedNode(const std::string name, const Resource *geometry, const Resource *material, const Resource *texture) : SceneNode(name, geometry, material, texture) {
+
+    glGenBuffers(1, &instance_buffer_);
+
+    // The batch needs its own vertex array: the mesh layout plus one
+    // world matrix per instance, advanced once per instance
+    glGenVertexArrays(1, &vertex_array_);
+    SetupVertexArray(geometry->GetVertexFormat());
+
+    instances_dirty_ = false;
+
+    // The batch starts empty; its bounds grow as instances are added
+    mesh_bounds_ = bounds_;
+    bounds_.radius = -1.0;
+}
+
+
+InstancedNode::~InstancedNode(){
+
+    // The batch owns its vertex array and instance buffer; the mesh
+    // buffers belong to the resource. Nothing to delete once the context
+    // is gone
+    if (glfwGetCurrentContext()){
+        glDeleteVertexArrays(1, &vertex_array_);
+        glDeleteBuffers(1, &instance_buffer_);
+    }
+}
+
+
+void InstancedNode::SetupVertexArray(const VertexFormat &format){
+
+    glBindVertexArray(vertex_array_);
+
+    glBindBuffer(GL_ARRAY_BUFFER, array_buffer_);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_array_buffer_);
+    SetupVertexAttributes(format);
+
+    glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+    for (int i = 0; i < 4; i++){
+        // A matrix attribute is four column attributes
+        glVertexAttribPointer(InstanceAttribute + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void *) (i*sizeof(glm::vec4)));
+        glEnableVertexAttribArray(InstanceAttribute + i);
+        glVertexAttribDivisor(InstanceAttribute + i, 1);
+    }
+
+    glBindVertexArray(0);
+}
+
+
+void InstancedNode::SetGeometry(const Resource *geometry){
+
+    // Keep the vertex array of the batch and point it at the new buffers
+    GLuint vertex_array = vertex_array_;
+    SceneNode::SetGeometry(geometry);
+    vertex_array_ = vertex_array;
+    SetupVertexArray(geometry->GetVertexFormat());
+
+    // Enclose the instances again with the extent of the new mesh
+    mesh_bounds_ = bounds_;
+    bounds_.radius = -1.0;
+    for (int i = 0; i < instance_position_.size(); i++){
+        EncloseInstance(i);
+    }
+}
+
+
+int InstancedNode::AddInstance(glm::vec3 position, glm::quat orientation, glm::vec3 scale){
+
+    instance_position_.push_back(position);
+    instance_orientation_.push_back(orientation);
+    instance_scale_.push_back(scale);
+    instance_spin_.push_back(glm::quat());
+    instance_matrix_.push_back(glm::mat4(1.0));
+    instances_dirty_ = true;
+    EncloseInstance(instance_position_.size() - 1);
+    return instance_position_.size() - 1;
+}
+
+
+int InstancedNode::GetInstanceCount(void) const {
+
+    return instance_position_.size();
+}
+
+
+glm::vec3 InstancedNode::GetInstancePosition(int index) const {
+
+    return instance_position_[index];
+}
+
+
+glm::quat InstancedNode::GetInstanceOrientation(int index) const {
+
+    return instance_orientation_[index];
+}
+
+
+void InstancedNode::SetInstancePosition(int index, glm::vec3 position){
+
+    instance_position_[index] = position;
+    instances_dirty_ = true;
+    EncloseInstance(index);
+}
+
+
+void InstancedNode::SetInstanceOrientation(int index, glm::quat orientation){
+
+    instance_orientation_[index] = orientation;
+    instances_dirty_ = true;
+}
+
+
+void InstancedNode::SetInstanceScale(int index, glm::vec3 scale){
+
+    instance_scale_[index] = scale;
+    instances_dirty_ = true;
+    EncloseInstance(index);
+}
+
+
+void InstancedNode::SetInstanceSpin(int index, glm::quat spin){
+
+    instance_spin_[index] = spin;
+}
+
+
+void InstancedNode::Update(void){
+
+    // Same rotation as Asteroid::Update, for every instance
+    for (int i = 0; i < instance_orientation_.size(); i++){
+        instance_orientation_[i] = glm::normalize(instance_orientation_[i] * instance_spin_[i]);
+    }
+    if (!instance_orientation_.empty()){
+        instances_dirty_ = true;
+    }
+}
+
+
+void InstancedNode::EncloseInstance(int index){
+
+    if (mesh_bounds_.radius < 0.0){
+        return;
+    }
+
+    // Sphere around the instance origin that holds the mesh in any
+    // orientation, so spinning never changes the bounds
+    glm::vec3 scale = instance_scale_[index];
+    float radius = (glm::length(mesh_bounds_.center) + mesh_bounds_.radius) * glm::max(scale.x, glm::max(scale.y, scale.z));
+    glm::vec3 box_min = instance_position_[index] - glm::vec3(radius);
+    glm::vec3 box_max = instance_position_[index] + glm::vec3(radius);
+
+    // The bounds only grow: moved instances keep their old extent
+    if (bounds_.radius < 0.0){
+        bounds_.box_min = box_min;
+        bounds_.box_max = box_max;
+    } else {
+        bounds_.box_min = glm::min(bounds_.box_min, box_min);
+        bounds_.box_max = glm::max(bounds_.box_max, box_max);
+    }
+    bounds_.center = 0.5f*(bounds_.box_min + bounds_.box_max);
+    bounds_.radius = 0.5f*glm::length(bounds_.box_max - bounds_.box_min);
+
+    // Refresh the world bounds on the next update
+    Invalidate();
+}
+
+
+void InstancedNode::DrawBound(void){
+
+    if (instance_position_.empty()){
+        return;
+    }
+
+    // Rebuild and upload the instance matrices only when they changed
+    if (instances_dirty_){
+        for (int i = 0; i < instance_position_.size(); i++){
+            glm::mat4 transf = glm::translate(glm::mat4(1.0), instance_position_[i]);
+            transf *= glm::mat4_cast(instance_orientation_[i]);
+            instance_matrix_[i] = glm::scale(transf, instance_scale_[i]);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+        // Orphan the old storage so the upload does not wait for the GPU
+        glBufferData(GL_ARRAY_BUFFER, instance_matrix_.size() * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instance_matrix_.size() * sizeof(glm::mat4), glm::value_ptr(instance_matrix_[0]));
+        instances_dirty_ = false;
+    }
+
+    // Transformation of the whole batch
+    glUniformMatrix4fv(locations_->world_mat, 1, GL_FALSE, glm::value_ptr(world_matrix_));
+    glUniformMatrix4fv(locations_->normal_mat, 1, GL_FALSE, glm::value_ptr(normal_matrix_));
+
+    // Draw all instances
+    if (mode_ == GL_POINTS){
+        glDrawArraysInstanced(mode_, 0, size_, instance_position_.size());
+    } else {
+        glDrawElementsInstanced(mode_, size_, GL_UNSIGNED_INT, 0, instance_position_.size());
+    }
+}
+
+} // namespace game
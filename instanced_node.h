@@ -0,0 +1,80 @@
+#ifndef INSTANCED_NODE_H_
+#define INSTANCED_NODE_H_
+
+#include <string>
+#include <vector>
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#define GLM_FORCE_RADIANS
+#include <glm/gtc/quaternion.hpp>
+
+#include "resource.h"
+#include "scene_node.h"
+
+namespace game {
+
+    // A batch of copies of one mesh drawn with a single instanced draw call
+    // Each instance has its own position, orientation, scale and spin; the
+    // node's own transformation applies to the whole batch. Use with a
+    // material loaded by ResourceManager::LoadInstancedMaterial
+    class InstancedNode : public SceneNode {
+
+        public:
+            // Create batch from given resources
+            InstancedNode(const std::string name, const Resource *geometry, const Resource *material, const Resource *texture = NULL);
+
+            // Destructor
+            ~InstancedNode();
+
+            // Add an instance and return its index
+            int AddInstance(glm::vec3 position, glm::quat orientation = glm::quat(), glm::vec3 scale = glm::vec3(1.0, 1.0, 1.0));
+            int GetInstanceCount(void) const;
+
+            // Get/set attributes of one instance
+            glm::vec3 GetInstancePosition(int index) const;
+            glm::quat GetInstanceOrientation(int index) const;
+            void SetInstancePosition(int index, glm::vec3 position);
+            void SetInstanceOrientation(int index, glm::quat orientation);
+            void SetInstanceScale(int index, glm::vec3 scale);
+            // Rotation applied to the instance on every update
+            void SetInstanceSpin(int index, glm::quat spin);
+
+            // Spin the instances
+            void Update(void);
+
+            // Upload changed instances and draw all of them
+            void DrawBound(void);
+
+        protected:
+            // Buffer with one world matrix per instance
+            GLuint instance_buffer_;
+
+            // Record the mesh layout and the instance matrices in the
+            // vertex array of the batch
+            void SetupVertexArray(const VertexFormat &format);
+            // Use the mesh buffers in the batch's own vertex array
+            void SetGeometry(const Resource *geometry);
+
+        private:
+            // Per-instance attributes
+            std::vector<glm::vec3> instance_position_;
+            std::vector<glm::quat> instance_orientation_;
+            std::vector<glm::vec3> instance_scale_;
+            std::vector<glm::quat> instance_spin_;
+            // World matrices sent to the instance buffer
+            std::vector<glm::mat4> instance_matrix_;
+            // Instances changed since the last upload
+            bool instances_dirty_;
+            // Extent of one copy of the mesh
+            Bounds mesh_bounds_;
+
+            // Grow the bounds of the batch to enclose an instance
+            void EncloseInstance(int index);
+
+    }; // class InstancedNode
+
+} // namespace game
+
+#endif // INSTANCED_NODE_H_
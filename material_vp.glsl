@@ -1,6 +1,7 @@
 // Material with no illumination simulation
 
 #version 130
+#extension GL_ARB_uniform_buffer_object : require
 
 // Vertex buffer
 in vec3 vertex;
@@ -8,8 +9,16 @@ in vec3 color;
 
 // Uniform (global) buffer
 uniform mat4 world_mat;
-uniform mat4 view_mat;
-uniform mat4 projection_mat;
+
+// Per-frame constants shared by all programs (see frame_globals.h)
+layout(std140) uniform FrameGlobals {
+    mat4 view_mat;
+    mat4 projection_mat;
+    vec4 camera_position;
+    vec4 light_position[2];
+    vec4 material_light_position[2];
+    vec4 timer;
+};
 
 // Attributes forwarded to the fragment shader
 out vec4 color_interp;
@@ -0,0 +1,242 @@
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <system_error>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mesh_cache.h"
+
+namespace game {
+
+MappedFile::MappedFile(void){
+
+    data_ = NULL;
+    size_ = 0;
+#ifdef _WIN32
+    file_ = INVALID_HANDLE_VALUE;
+    mapping_ = NULL;
+#endif
+}
+
+
+MappedFile::~MappedFile(){
+
+    Close();
+}
+
+
+bool MappedFile::Open(const std::string &filename){
+
+    Close();
+
+#ifdef _WIN32
+    file_ = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file_ == INVALID_HANDLE_VALUE){
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file_, &size) || (size.QuadPart == 0)){
+        Close();
+        return false;
+    }
+    mapping_ = CreateFileMappingA(file_, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping_){
+        Close();
+        return false;
+    }
+    data_ = (const unsigned char *) MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+    if (!data_){
+        Close();
+        return false;
+    }
+    size_ = (size_t) size.QuadPart;
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0){
+        return false;
+    }
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || (st.st_size == 0)){
+        close(fd);
+        return false;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+    if (data == MAP_FAILED){
+        return false;
+    }
+    data_ = (const unsigned char *) data;
+    size_ = st.st_size;
+#endif
+
+    return true;
+}
+
+
+void MappedFile::Close(void){
+
+#ifdef _WIN32
+    if (data_){
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_){
+        CloseHandle(mapping_);
+    }
+    if (file_ != INVALID_HANDLE_VALUE){
+        CloseHandle(file_);
+    }
+    mapping_ = NULL;
+    file_ = INVALID_HANDLE_VALUE;
+#else
+    if (data_){
+        munmap((void *) data_, size_);
+    }
+#endif
+    data_ = NULL;
+    size_ = 0;
+}
+
+
+const unsigned char *MappedFile::GetData(void) const {
+
+    return data_;
+}
+
+
+size_t MappedFile::GetSize(void) const {
+
+    return size_;
+}
+
+
+uint64_t HashBytes(const void *data, size_t size, uint64_t seed){
+
+    const unsigned char *bytes = (const unsigned char *) data;
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; i++){
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+
+uint64_t HashFileStamp(const char *filename, uint64_t seed){
+
+    std::error_code error;
+    uintmax_t size = std::filesystem::file_size(filename, error);
+    if (error){
+        return 0;
+    }
+    long long time = std::filesystem::last_write_time(filename, error).time_since_epoch().count();
+    if (error){
+        return 0;
+    }
+    uint64_t hash = HashBytes(&size, sizeof(size), seed);
+    return HashBytes(&time, sizeof(time), hash);
+}
+
+
+bool ReadMeshCache(const std::string &filename, uint64_t key, CachedMesh &mesh){
+
+    if (!mesh.file.Open(filename)){
+        return false;
+    }
+
+    // Check the header and that the blobs fit in the file
+    MeshCacheHeader header;
+    if (mesh.file.GetSize() < sizeof(header)){
+        mesh.file.Close();
+        return false;
+    }
+    memcpy(&header, mesh.file.GetData(), sizeof(header));
+    size_t expected = sizeof(header) + header.vertex_size + header.index_num * sizeof(GLuint);
+    if ((header.magic != MESH_CACHE_MAGIC) || (header.version != MESH_CACHE_VERSION) ||
+        (header.key != key) || (mesh.file.GetSize() != expected)){
+        mesh.file.Close();
+        return false;
+    }
+
+    for (int i = 0; i < 4; i++){
+        mesh.format.attribute[i].enabled = header.attribute[i][0] != 0;
+        mesh.format.attribute[i].size = header.attribute[i][1];
+        mesh.format.attribute[i].type = header.attribute[i][2];
+        mesh.format.attribute[i].normalized = (GLboolean) header.attribute[i][3];
+        mesh.format.attribute[i].offset = header.attribute[i][4];
+    }
+    mesh.format.stride = header.stride;
+    mesh.bounds.box_min = glm::vec3(header.bounds[0], header.bounds[1], header.bounds[2]);
+    mesh.bounds.box_max = glm::vec3(header.bounds[3], header.bounds[4], header.bounds[5]);
+    mesh.bounds.center = glm::vec3(header.bounds[6], header.bounds[7], header.bounds[8]);
+    mesh.bounds.radius = header.bounds[9];
+
+    // The header keeps the blobs 4-byte aligned in the page-aligned
+    // mapping, so the indices can be used in place
+    mesh.vertex = mesh.file.GetData() + sizeof(header);
+    mesh.vertex_size = header.vertex_size;
+    mesh.face = (const GLuint *) (mesh.file.GetData() + sizeof(header) + header.vertex_size);
+    mesh.index_num = header.index_num;
+
+    return true;
+}
+
+
+void WriteMeshCache(const std::string &filename, uint64_t key, const VertexFormat &format, const Bounds &bounds, const std::vector<unsigned char> &vertex, const std::vector<GLuint> &face){
+
+    MeshCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = MESH_CACHE_MAGIC;
+    header.version = MESH_CACHE_VERSION;
+    header.key = key;
+    header.vertex_size = vertex.size();
+    header.index_num = face.size();
+    header.stride = format.stride;
+    for (int i = 0; i < 4; i++){
+        header.attribute[i][0] = format.attribute[i].enabled;
+        header.attribute[i][1] = format.attribute[i].size;
+        header.attribute[i][2] = format.attribute[i].type;
+        header.attribute[i][3] = format.attribute[i].normalized;
+        header.attribute[i][4] = format.attribute[i].offset;
+    }
+    float box[10] = { bounds.box_min.x, bounds.box_min.y, bounds.box_min.z,
+                      bounds.box_max.x, bounds.box_max.y, bounds.box_max.z,
+                      bounds.center.x, bounds.center.y, bounds.center.z, bounds.radius };
+    memcpy(header.bounds, box, sizeof(box));
+
+    // Write to a temporary file and rename it, so a reader never maps a
+    // partly written file
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(filename).parent_path(), error);
+    std::string temporary = filename + ".tmp";
+    std::ofstream f(temporary.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (f.fail()){
+        return;
+    }
+    f.write((const char *) &header, sizeof(header));
+    if (!vertex.empty()){
+        f.write((const char *) &vertex[0], vertex.size());
+    }
+    if (!face.empty()){
+        f.write((const char *) &face[0], face.size() * sizeof(GLuint));
+    }
+    f.close();
+    if (f.fail()){
+        std::filesystem::remove(temporary, error);
+        return;
+    }
+    std::filesystem::rename(temporary, filename, error);
+    if (error){
+        std::filesystem::remove(temporary, error);
+    }
+}
+
+} // namespace game
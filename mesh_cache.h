@@ -0,0 +1,87 @@
+#ifndef MESH_CACHE_H_
+#define MESH_CACHE_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include "resource.h"
+
+// Identifies mesh cache files; bump the version when the layout or the
+// mesh processing changes so old files are rebuilt
+#define MESH_CACHE_MAGIC 0x4853454d // "MESH"
+#define MESH_CACHE_VERSION 1
+// Extension of mesh cache files
+#define MESH_CACHE_EXTENSION ".mesh"
+
+namespace game {
+
+    // Header of a mesh cache file, followed by the vertex buffer contents
+    // and then the indices, both ready to be copied to OpenGL buffers
+    struct MeshCacheHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key; // Hash of the source of the mesh
+        uint32_t vertex_size; // Bytes of vertex data
+        uint32_t index_num; // Number of indices
+        uint32_t stride;
+        uint32_t attribute[4][5]; // enabled, size, type, normalized, offset
+        float bounds[10]; // box min, box max, sphere center and radius
+    };
+
+    // Read-only view of a whole file mapped in memory
+    class MappedFile {
+
+        public:
+            MappedFile(void);
+            ~MappedFile();
+
+            // Map a file; returns false if it cannot be opened
+            bool Open(const std::string &filename);
+            void Close(void);
+
+            const unsigned char *GetData(void) const;
+            size_t GetSize(void) const;
+
+        private:
+            const unsigned char *data_;
+            size_t size_;
+#ifdef _WIN32
+            void *file_;
+            void *mapping_;
+#endif
+
+            // Mappings are not copied
+            MappedFile(const MappedFile &);
+            MappedFile &operator=(const MappedFile &);
+
+    }; // class MappedFile
+
+    // A mesh read from a cache file; the data pointers refer to the mapped
+    // file and stay valid while 'file' is open
+    struct CachedMesh {
+        MappedFile file;
+        VertexFormat format;
+        Bounds bounds;
+        const void *vertex;
+        size_t vertex_size;
+        const GLuint *face;
+        size_t index_num;
+    };
+
+    // Hash bytes into a key, continuing from 'seed' (FNV-1a)
+    uint64_t HashBytes(const void *data, size_t size, uint64_t seed = 14695981039346656037ull);
+    // Key of a source file from its size and modification time; 0 if
+    // the file does not exist
+    uint64_t HashFileStamp(const char *filename, uint64_t seed);
+
+    // Map a cache file and check it was built from the source with 'key'
+    bool ReadMeshCache(const std::string &filename, uint64_t key, CachedMesh &mesh);
+    // Write a cache file; failures only mean the mesh is rebuilt next time
+    void WriteMeshCache(const std::string &filename, uint64_t key, const VertexFormat &format, const Bounds &bounds, const std::vector<unsigned char> &vertex, const std::vector<GLuint> &face);
+
+} // namespace game
+
+#endif // MESH_CACHE_H_
@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <cmath>
+#include <glm/glm.hpp>
+
+#include "mesh_optimizer.h"
+
+namespace game {
+
+float ComputeAcmr(const std::vector<GLuint> &face, int vertex_num, int cache_size){
+
+    if (face.size() < 3){
+        return 0.0;
+    }
+
+    // A vertex is in the FIFO cache if fewer than 'cache_size' misses
+    // happened since it was loaded
+    std::vector<int> loaded(vertex_num, -1);
+    int misses = 0;
+    for (unsigned int i = 0; i < face.size(); i++){
+        int v = face[i];
+        if ((loaded[v] < 0) || (misses - loaded[v] > cache_size)){
+            loaded[v] = misses;
+            misses++;
+        }
+    }
+
+    return (float) misses / (float) (face.size() / 3);
+}
+
+
+// Score of a vertex in Forsyth's algorithm: vertices recently used and
+// vertices with few triangles left are preferred, so that triangles are
+// emitted while their vertices are still cached and no lone triangles
+// are left behind
+static float VertexScore(int cache_position, int remaining){
+
+    if (remaining == 0){
+        return -1.0;
+    }
+
+    float score = 0.0;
+    if (cache_position >= 0){
+        if (cache_position < 3){
+            // Vertices of the last triangle: fixed score so the next
+            // triangle does not just reuse the same edge
+            score = 0.75;
+        } else {
+            float s = 1.0 - (float) (cache_position - 3) / (float) (VERTEX_CACHE_SIZE - 3);
+            score = pow(s, 1.5f);
+        }
+    }
+    score += 2.0 * pow((float) remaining, -0.5f);
+
+    return score;
+}
+
+
+void OptimizeVertexCache(std::vector<GLuint> &face, int vertex_num){
+
+    int tri_num = face.size() / 3;
+    if (tri_num == 0){
+        return;
+    }
+
+    // Triangles using each vertex, stored contiguously per vertex
+    std::vector<int> remaining(vertex_num, 0);
+    for (unsigned int i = 0; i < tri_num * 3; i++){
+        remaining[face[i]]++;
+    }
+    std::vector<int> offset(vertex_num + 1, 0);
+    for (int v = 0; v < vertex_num; v++){
+        offset[v + 1] = offset[v] + remaining[v];
+    }
+    std::vector<int> adjacency(tri_num * 3);
+    std::vector<int> fill(offset.begin(), offset.end() - 1);
+    for (int t = 0; t < tri_num; t++){
+        for (int k = 0; k < 3; k++){
+            adjacency[fill[face[t*3 + k]]++] = t;
+        }
+    }
+
+    // Initial scores
+    std::vector<int> cache_position(vertex_num, -1);
+    std::vector<float> vertex_score(vertex_num);
+    for (int v = 0; v < vertex_num; v++){
+        vertex_score[v] = VertexScore(-1, remaining[v]);
+    }
+    std::vector<float> tri_score(tri_num);
+    std::vector<bool> added(tri_num, false);
+    int best = 0;
+    for (int t = 0; t < tri_num; t++){
+        tri_score[t] = vertex_score[face[t*3]] + vertex_score[face[t*3 + 1]] + vertex_score[face[t*3 + 2]];
+        if (tri_score[t] > tri_score[best]){
+            best = t;
+        }
+    }
+
+    // Modeled LRU cache, with room for the vertices of one more triangle
+    int cache[VERTEX_CACHE_SIZE + 3];
+    int cache_num = 0;
+    int cursor = 0;
+
+    std::vector<GLuint> output;
+    output.reserve(tri_num * 3);
+    for (int n = 0; n < tri_num; n++){
+        // No candidate in the cache: restart from the first triangle left
+        if (best < 0){
+            while (added[cursor]){
+                cursor++;
+            }
+            best = cursor;
+        }
+
+        // Emit the triangle and remove it from the lists of its vertices
+        added[best] = true;
+        int new_cache[VERTEX_CACHE_SIZE + 3];
+        int new_num = 0;
+        for (int k = 0; k < 3; k++){
+            int v = face[best*3 + k];
+            output.push_back(v);
+            int *list = &adjacency[offset[v]];
+            for (int i = 0; i < remaining[v]; i++){
+                if (list[i] == best){
+                    std::swap(list[i], list[remaining[v] - 1]);
+                    break;
+                }
+            }
+            remaining[v]--;
+            new_cache[new_num++] = v;
+        }
+
+        // Move the vertices of the triangle to the front of the cache
+        for (int i = 0; i < cache_num; i++){
+            int v = cache[i];
+            if ((v != new_cache[0]) && (v != new_cache[1]) && (v != new_cache[2])){
+                new_cache[new_num++] = v;
+            }
+        }
+
+        // Rescore the vertices that moved, including those pushed out, and
+        // the triangles that use them
+        for (int i = 0; i < new_num; i++){
+            int v = new_cache[i];
+            cache_position[v] = (i < VERTEX_CACHE_SIZE) ? i : -1;
+            float score = VertexScore(cache_position[v], remaining[v]);
+            float delta = score - vertex_score[v];
+            vertex_score[v] = score;
+            for (int j = offset[v]; j < offset[v] + remaining[v]; j++){
+                tri_score[adjacency[j]] += delta;
+            }
+        }
+        cache_num = std::min(new_num, VERTEX_CACHE_SIZE);
+        for (int i = 0; i < cache_num; i++){
+            cache[i] = new_cache[i];
+        }
+
+        // Next triangle: the best one using a cached vertex
+        best = -1;
+        float best_score = -1.0;
+        for (int i = 0; i < cache_num; i++){
+            int v = cache[i];
+            for (int j = offset[v]; j < offset[v] + remaining[v]; j++){
+                int t = adjacency[j];
+                if (tri_score[t] > best_score){
+                    best = t;
+                    best_score = tri_score[t];
+                }
+            }
+        }
+    }
+
+    face.swap(output);
+}
+
+
+// A run of consecutive triangles and its sort key
+struct Cluster {
+    int start, end;
+    float key;
+    bool operator<(const Cluster &other) const {
+        return key > other.key;
+    }
+};
+
+
+void OptimizeOverdraw(std::vector<GLuint> &face, const std::vector<GLfloat> &vertex, int vertex_att){
+
+    int tri_num = face.size() / 3;
+    int vertex_num = vertex.size() / vertex_att;
+    if (tri_num == 0){
+        return;
+    }
+
+    // Split where all three vertices of a triangle miss the cache: the
+    // order of whole clusters can change there without extra misses
+    std::vector<Cluster> cluster;
+    std::vector<int> loaded(vertex_num, -1);
+    int misses = 0;
+    Cluster current;
+    current.start = 0;
+    for (int t = 0; t < tri_num; t++){
+        int tri_misses = 0;
+        for (int k = 0; k < 3; k++){
+            int v = face[t*3 + k];
+            if ((loaded[v] < 0) || (misses - loaded[v] > VERTEX_FIFO_SIZE)){
+                loaded[v] = misses;
+                misses++;
+                tri_misses++;
+            }
+        }
+        if ((tri_misses == 3) && (t > current.start)){
+            current.end = t;
+            cluster.push_back(current);
+            current.start = t;
+        }
+    }
+    current.end = tri_num;
+    cluster.push_back(current);
+
+    // Center of the mesh
+    glm::vec3 mesh_center(0.0);
+    for (int v = 0; v < vertex_num; v++){
+        mesh_center += glm::vec3(vertex[v*vertex_att], vertex[v*vertex_att + 1], vertex[v*vertex_att + 2]);
+    }
+    mesh_center /= (float) std::max(vertex_num, 1);
+
+    // Clusters facing outwards occlude the others from most directions
+    for (unsigned int c = 0; c < cluster.size(); c++){
+        glm::vec3 center(0.0);
+        glm::vec3 normal(0.0);
+        float area = 0.0;
+        for (int t = cluster[c].start; t < cluster[c].end; t++){
+            glm::vec3 p[3];
+            for (int k = 0; k < 3; k++){
+                const GLfloat *position = &vertex[face[t*3 + k]*vertex_att];
+                p[k] = glm::vec3(position[0], position[1], position[2]);
+            }
+            // Area-weighted normal and centroid
+            glm::vec3 n = glm::cross(p[1] - p[0], p[2] - p[0]);
+            float a = glm::length(n);
+            normal += n;
+            center += (p[0] + p[1] + p[2]) * (a / 3.0f);
+            area += a;
+        }
+        float length = glm::length(normal);
+        if ((area > 0.0) && (length > 0.0)){
+            center /= area;
+            cluster[c].key = glm::dot(center - mesh_center, normal / length);
+        } else {
+            cluster[c].key = 0.0;
+        }
+    }
+    std::stable_sort(cluster.begin(), cluster.end());
+
+    std::vector<GLuint> output;
+    output.reserve(face.size());
+    for (unsigned int c = 0; c < cluster.size(); c++){
+        output.insert(output.end(), face.begin() + cluster[c].start*3, face.begin() + cluster[c].end*3);
+    }
+    face.swap(output);
+}
+
+
+void OptimizeVertexFetch(std::vector<GLfloat> &vertex, std::vector<GLuint> &face, int vertex_att){
+
+    int vertex_num = vertex.size() / vertex_att;
+
+    // New index of each vertex, in order of first use
+    std::vector<int> remap(vertex_num, -1);
+    int next = 0;
+    for (unsigned int i = 0; i < face.size(); i++){
+        if (remap[face[i]] < 0){
+            remap[face[i]] = next++;
+        }
+        face[i] = remap[face[i]];
+    }
+
+    std::vector<GLfloat> output(next * vertex_att);
+    for (int v = 0; v < vertex_num; v++){
+        if (remap[v] >= 0){
+            std::copy(vertex.begin() + v*vertex_att, vertex.begin() + (v + 1)*vertex_att, output.begin() + remap[v]*vertex_att);
+        }
+    }
+    vertex.swap(output);
+}
+
+} // namespace game
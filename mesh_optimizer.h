@@ -0,0 +1,42 @@
+#ifndef MESH_OPTIMIZER_H_
+#define MESH_OPTIMIZER_H_
+
+#include <vector>
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+// Number of entries of the post-transform cache modeled by the optimizer
+#define VERTEX_CACHE_SIZE 32
+// Number of entries of the FIFO cache used to measure meshes, close to
+// the size of the caches of actual hardware
+#define VERTEX_FIFO_SIZE 16
+
+namespace game {
+
+    // Reordering of indexed triangle meshes for the GPU
+    // All functions work on triangle lists: every three entries of
+    // 'face' form one triangle
+
+    // Average cache miss ratio: vertices transformed per triangle with a
+    // FIFO cache of 'cache_size' entries; 0.5 is ideal on large regular
+    // meshes, 3.0 means no vertex is reused
+    float ComputeAcmr(const std::vector<GLuint> &face, int vertex_num, int cache_size = VERTEX_FIFO_SIZE);
+
+    // Reorder triangles so that vertices are reused while they are still
+    // in the cache (Forsyth's linear-speed algorithm)
+    void OptimizeVertexCache(std::vector<GLuint> &face, int vertex_num);
+
+    // Reorder clusters of triangles produced by OptimizeVertexCache so
+    // that those facing away from the center of the mesh come first and
+    // occlude the rest, which reduces overdraw from most view directions
+    // Clusters end where the cache would be refilled anyway, so the cache
+    // efficiency is kept
+    void OptimizeOverdraw(std::vector<GLuint> &face, const std::vector<GLfloat> &vertex, int vertex_att);
+
+    // Renumber vertices in the order triangles first use them and drop
+    // unused ones, so vertex fetches walk through memory sequentially
+    void OptimizeVertexFetch(std::vector<GLfloat> &vertex, std::vector<GLuint> &face, int vertex_att);
+
+} // namespace game
+
+#endif // MESH_OPTIMIZER_H_
@@ -1,6 +1,7 @@
 // Illumination using the physically-based model
 
 #version 130
+#extension GL_ARB_uniform_buffer_object : require
 
 // Vertex buffer
 in vec3 vertex;
@@ -10,19 +11,24 @@ in vec2 uv;
 
 // Uniform (global) buffer
 uniform mat4 world_mat;
-uniform mat4 view_mat;
-uniform mat4 projection_mat;
 uniform mat4 normal_mat;
 
+// Per-frame constants shared by all programs (see frame_globals.h)
+layout(std140) uniform FrameGlobals {
+    mat4 view_mat;
+    mat4 projection_mat;
+    vec4 camera_position;
+    vec4 light_position[2];
+    vec4 material_light_position[2];
+    vec4 timer;
+};
+
 // Attributes forwarded to the fragment shader
 out vec3 position_interp;
 out vec3 normal_interp;
 out vec2 uv_interp;
 out vec3 light_pos[2];
 
-// Material attributes (constants)
-vec3 light_position = vec3(-0.5, -0.5, 1.5);
-vec3 light_position2 = vec3(4.0, -1.0, -1.0);
 
 void main()
 {
@@ -39,6 +45,6 @@ void main()
     uv_interp = uv;
 
     // Transform light position to align with view
-    light_pos[0] = vec3(view_mat * vec4(light_position, 1.0));
-	light_pos[1] = vec3(view_mat * vec4(light_position2, 1.0));
+    light_pos[0] = vec3(view_mat * material_light_position[0]);
+	light_pos[1] = vec3(view_mat * material_light_position[1]);
 }
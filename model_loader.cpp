@@ -0,0 +1,214 @@
+#include <charconv>
+#include <cstring>
+#include <fstream>
+
+#include "model_loader.h"
+
+namespace game {
+
+// Tokenizing helpers for parse_obj
+// They work on the buffer in place and never allocate
+
+// Skip spaces and tabs
+static const char *skip_blanks(const char *p, const char *end){
+
+    while ((p < end) && ((*p == ' ') || (*p == '\t'))){
+        p++;
+    }
+    return p;
+}
+
+
+// Skip to the first character of the next line
+static const char *skip_line(const char *p, const char *end){
+
+    const char *eol = (const char *) memchr(p, '\n', end - p);
+    return eol ? eol + 1 : end;
+}
+
+
+// Check if p is at the end of the current line
+static bool at_line_end(const char *p, const char *end){
+
+    return (p >= end) || (*p == '\n') || (*p == '\r') || (*p == '#');
+}
+
+
+// Parse one float separated by blanks
+static const char *parse_float(const char *p, const char *end, float &value, int line){
+
+    p = skip_blanks(p, end);
+    // from_chars does not accept an explicit plus sign
+    if ((p < end) && (*p == '+')){
+        p++;
+    }
+    std::from_chars_result result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()){
+        throw(std::ios_base::failure(std::string("Error: invalid number on line ")+std::to_string(line)));
+    }
+    return result.ptr;
+}
+
+
+// Parse one vertex of an f command: v, v/t, v//n or v/t/n
+// Indices are returned zero-based; negative (relative) indices are
+// resolved against the current number of elements, and missing ones
+// are set to -1
+static const char *parse_face_vertex(const char *p, const char *end, const TriMesh &mesh, int &i, int &t, int &n, int line){
+
+    int index[3] = { -1, -1, -1 };
+    int count[3] = { (int) mesh.position.size(), (int) mesh.tex_coord.size(), (int) mesh.normal.size() };
+    for (int k = 0; k < 3; k++){
+        if (k > 0){
+            if ((p >= end) || (*p != '/')){
+                break;
+            }
+            p++;
+        }
+        // Empty field, as in v//n; the position is required
+        if (at_line_end(p, end) || (*p == '/') || (*p == ' ') || (*p == '\t')){
+            if (k == 0){
+                throw(std::ios_base::failure(std::string("Error: missing vertex index on line ")+std::to_string(line)));
+            }
+            continue;
+        }
+        int value;
+        std::from_chars_result result = std::from_chars(p, end, value);
+        if ((result.ec != std::errc()) || (value == 0)){
+            throw(std::ios_base::failure(std::string("Error: invalid face index on line ")+std::to_string(line)));
+        }
+        p = result.ptr;
+        index[k] = (value > 0) ? value - 1 : count[k] + value;
+        if (index[k] < 0){
+            throw(std::ios_base::failure(std::string("Error: relative face index out of bounds on line ")+std::to_string(line)));
+        }
+    }
+    i = index[0];
+    t = index[1];
+    n = index[2];
+    return p;
+}
+
+
+// Count the lines starting with each command, to reserve the mesh
+static void count_commands(const char *p, const char *end, TriMesh &mesh){
+
+    size_t num_v = 0, num_vn = 0, num_vt = 0, num_f = 0;
+    while (p < end){
+        p = skip_blanks(p, end);
+        if ((end - p) >= 2){
+            if (p[0] == 'v'){
+                if ((p[1] == ' ') || (p[1] == '\t')){
+                    num_v++;
+                } else if (p[1] == 'n'){
+                    num_vn++;
+                } else if (p[1] == 't'){
+                    num_vt++;
+                }
+            } else if ((p[0] == 'f') && ((p[1] == ' ') || (p[1] == '\t'))){
+                num_f++;
+            }
+        }
+        p = skip_line(p, end);
+    }
+
+    mesh.position.reserve(num_v);
+    mesh.normal.reserve(num_vn);
+    mesh.tex_coord.reserve(num_vt);
+    // Faces are usually triangles or quads
+    mesh.face.reserve(num_f * 2);
+}
+
+
+void parse_obj(const char *data, size_t size, TriMesh &mesh){
+
+    const char *p = data;
+    const char *end = data + size;
+
+    count_commands(p, end, mesh);
+
+    int line = 0;
+    while (p < end){
+        line++;
+        p = skip_blanks(p, end);
+        if (at_line_end(p, end)){
+            // Empty line or comment
+            p = skip_line(p, end);
+            continue;
+        }
+
+        // Command name
+        const char *command = p;
+        while ((p < end) && (*p != ' ') && (*p != '\t') && !at_line_end(p, end)){
+            p++;
+        }
+        size_t command_size = p - command;
+
+        if ((command_size == 1) && (command[0] == 'v')){
+            glm::vec3 position;
+            p = parse_float(p, end, position.x, line);
+            p = parse_float(p, end, position.y, line);
+            p = parse_float(p, end, position.z, line);
+            mesh.position.push_back(position);
+        } else if ((command_size == 2) && !strncmp(command, "vn", 2)){
+            glm::vec3 normal;
+            p = parse_float(p, end, normal.x, line);
+            p = parse_float(p, end, normal.y, line);
+            p = parse_float(p, end, normal.z, line);
+            mesh.normal.push_back(normal);
+        } else if ((command_size == 2) && !strncmp(command, "vt", 2)){
+            glm::vec2 tex_coord;
+            p = parse_float(p, end, tex_coord.x, line);
+            p = parse_float(p, end, tex_coord.y, line);
+            mesh.tex_coord.push_back(tex_coord);
+        } else if ((command_size == 1) && (command[0] == 'f')){
+            // Polygons are split into a fan of triangles around the first
+            // vertex as they are read, so any number of vertices works
+            Face face;
+            int num_vertices = 0;
+            p = skip_blanks(p, end);
+            while (!at_line_end(p, end)){
+                int k = (num_vertices < 3) ? num_vertices : 2;
+                if (num_vertices >= 3){
+                    // Previous vertex becomes the second one of the next
+                    // triangle
+                    face.i[1] = face.i[2]; face.t[1] = face.t[2]; face.n[1] = face.n[2];
+                }
+                p = parse_face_vertex(p, end, mesh, face.i[k], face.t[k], face.n[k], line);
+                num_vertices++;
+                if (num_vertices >= 3){
+                    mesh.face.push_back(face);
+                }
+                p = skip_blanks(p, end);
+            }
+            if (num_vertices < 3){
+                throw(std::ios_base::failure(std::string("Error: f command should have at least 3 vertices on line ")+std::to_string(line)));
+            }
+        }
+        // Ignore other commands
+
+        p = skip_line(p, end);
+    }
+}
+
+
+void load_obj(const char *filename, TriMesh &mesh){
+
+    // Read the whole file with a single call
+    std::ifstream f(filename, std::ios::in | std::ios::binary);
+    if (f.fail()){
+        throw(std::ios_base::failure(std::string("Error opening file ")+std::string(filename)));
+    }
+    f.seekg(0, std::ios::end);
+    std::streamoff size = f.tellg();
+    f.seekg(0, std::ios::beg);
+    std::vector<char> data((size_t) size);
+    if (size > 0){
+        f.read(&data[0], size);
+    }
+    f.close();
+
+    parse_obj(data.empty() ? NULL : &data[0], data.size(), mesh);
+}
+
+} // namespace game;
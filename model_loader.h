@@ -5,6 +5,7 @@
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <vector>
 #define GLEW_STATIC
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -21,13 +22,6 @@ struct Face {
     int t[3];
 };
 
-// A quad face
-struct Quad {
-    int i[4];
-    int n[4];
-    int t[4];
-};
-
 // A mesh stored in memory
 struct TriMesh {
     std::vector<glm::vec3> position;
@@ -36,20 +30,18 @@ struct TriMesh {
     std::vector<Face> face;
 };
 
+// Parse a mesh in obj format from 'size' characters in memory
+// Supports v, vn, vt and f commands; faces with more than three vertices
+// are split into triangles. Throws std::ios_base::failure on errors
+void parse_obj(const char *data, size_t size, TriMesh &mesh);
+// Read an obj file with a single read and parse it
+void load_obj(const char *filename, TriMesh &mesh);
+
 // Helper functions 
-// Trim any character in to_trim from the beginning and end of str
-void string_trim(std::string str, std::string to_trim);
-// Split string into substrings according to characters in separator
-std::vector<std::string> string_split(std::string str, std::string separator);
-// Split string into substrings according to characters in separator. A
-// split is performed when one separator character is found, rather than
-// a sequence of separators
-std::vector<std::string> string_split_once(std::string str, std::string separator);
 // Print a mesh stored internally
 void print_mesh(TriMesh &mesh);
-// Conversion between strings and numbers
+// Conversion between numbers and strings
 template <typename T> std::string num_to_str(T num);
-template <typename T> T str_to_num(const std::string &str);
 
 } // namespace game;
 
@@ -0,0 +1,81 @@
+// Parse throughput benchmark for the obj loader
+//
+// Not part of the game executable; build it on its own, for example:
+//   g++ -O2 -std=c++17 -I<glm, glew and glfw includes> obj_parse_bench.cpp model_loader.cpp
+//
+// Usage: obj_parse_bench [file.obj] [iterations]
+// Without a file, a synthetic high-poly grid is generated in memory
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "model_loader.h"
+
+// Build an obj grid of (n+1)^2 vertices with normals and texture
+// coordinates, written as quads so the triangulation path is exercised
+static std::string make_grid(int n){
+
+    std::ostringstream ss;
+    ss << "# synthetic grid " << n << "x" << n << "\n";
+    for (int i = 0; i <= n; i++){
+        for (int j = 0; j <= n; j++){
+            ss << "v " << (float) i / n - 0.5f << " " << 0.01f * ((i * 7 + j * 13) % 17) << " " << (float) j / n - 0.5f << "\n";
+        }
+    }
+    for (int i = 0; i <= n; i++){
+        for (int j = 0; j <= n; j++){
+            ss << "vt " << (float) i / n << " " << (float) j / n << "\n";
+        }
+    }
+    ss << "vn 0.0 1.0 0.0\n";
+    for (int i = 0; i < n; i++){
+        for (int j = 0; j < n; j++){
+            int a = i * (n + 1) + j + 1;
+            int b = a + n + 1;
+            ss << "f " << a << "/" << a << "/1 " << b << "/" << b << "/1 " << b + 1 << "/" << b + 1 << "/1 " << a + 1 << "/" << a + 1 << "/1\n";
+        }
+    }
+    return ss.str();
+}
+
+
+int main(int argc, char *argv[]){
+
+    std::string data;
+    if (argc > 1){
+        std::ifstream f(argv[1], std::ios::in | std::ios::binary);
+        if (f.fail()){
+            fprintf(stderr, "Error opening file %s\n", argv[1]);
+            return 1;
+        }
+        std::ostringstream ss;
+        ss << f.rdbuf();
+        data = ss.str();
+    } else {
+        data = make_grid(500);
+    }
+    int iterations = (argc > 2) ? atoi(argv[2]) : 20;
+
+    size_t triangles = 0;
+    double best = 1e30;
+    for (int k = 0; k < iterations; k++){
+        game::TriMesh mesh;
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        game::parse_obj(data.data(), data.size(), mesh);
+        std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+        if (elapsed.count() < best){
+            best = elapsed.count();
+        }
+        triangles = mesh.face.size();
+    }
+
+    printf("%zu bytes, %zu triangles\n", data.size(), triangles);
+    printf("best of %d: %.3f ms, %.1f MB/s, %.2f M triangles/s\n", iterations, best * 1000.0, data.size() / best / 1e6, triangles / best / 1e6);
+
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <filesystem>
+#include <system_error>
+
+#include "program_cache.h"
+#include "mesh_cache.h"
+
+namespace game {
+
+bool ProgramBinarySupported(void){
+
+    // Some drivers expose the extension but no binary format
+    if (!GLEW_ARB_get_program_binary){
+        return false;
+    }
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+
+uint64_t ProgramCacheKey(const std::string &vertex_source, const std::string &fragment_source){
+
+    uint64_t key = HashBytes(vertex_source.data(), vertex_source.size());
+    key = HashBytes(fragment_source.data(), fragment_source.size(), key);
+    GLenum name[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    for (int i = 0; i < 3; i++){
+        const char *value = (const char *) glGetString(name[i]);
+        if (value){
+            key = HashBytes(value, strlen(value), key);
+        }
+    }
+    return key;
+}
+
+
+bool LoadProgramBinary(const std::string &filename, uint64_t key, GLuint program){
+
+    std::ifstream f(filename.c_str(), std::ios::in | std::ios::binary);
+    if (f.fail()){
+        return false;
+    }
+
+    ProgramCacheHeader header;
+    f.read((char *) &header, sizeof(header));
+    if (f.fail() || (header.magic != PROGRAM_CACHE_MAGIC) ||
+        (header.version != PROGRAM_CACHE_VERSION) || (header.key != key)){
+        return false;
+    }
+    std::vector<char> binary(header.length);
+    f.read(binary.data(), header.length);
+    if (f.fail()){
+        return false;
+    }
+
+    glProgramBinary(program, header.format, binary.data(), header.length);
+    return true;
+}
+
+
+void SaveProgramBinary(const std::string &filename, uint64_t key, GLuint program){
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0){
+        return;
+    }
+    std::vector<char> binary(length);
+    GLenum format;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    ProgramCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = PROGRAM_CACHE_MAGIC;
+    header.version = PROGRAM_CACHE_VERSION;
+    header.key = key;
+    header.format = format;
+    header.length = length;
+
+    // Write to a temporary file and rename it, like the mesh cache
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(filename).parent_path(), error);
+    std::string temporary = filename + ".tmp";
+    std::ofstream f(temporary.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (f.fail()){
+        return;
+    }
+    f.write((const char *) &header, sizeof(header));
+    f.write(binary.data(), length);
+    f.close();
+    if (f.fail()){
+        std::filesystem::remove(temporary, error);
+        return;
+    }
+    std::filesystem::rename(temporary, filename, error);
+    if (error){
+        std::filesystem::remove(temporary, error);
+    }
+}
+
+} // namespace game
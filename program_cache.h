@@ -0,0 +1,44 @@
+#ifndef PROGRAM_CACHE_H_
+#define PROGRAM_CACHE_H_
+
+#include <string>
+#include <cstdint>
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+// Identifies program cache files; bump the version when the layout
+// changes so old files are ignored
+#define PROGRAM_CACHE_MAGIC 0x474f5250 // "PROG"
+#define PROGRAM_CACHE_VERSION 1
+// Extension of program cache files
+#define PROGRAM_CACHE_EXTENSION ".program"
+
+namespace game {
+
+    // Header of a program cache file, followed by the binary returned by
+    // glGetProgramBinary
+    struct ProgramCacheHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key; // Hash of the sources and of the driver
+        uint32_t format; // Driver-specific binary format
+        uint32_t length; // Bytes of binary data
+    };
+
+    // Whether the driver can save and restore linked programs
+    bool ProgramBinarySupported(void);
+
+    // Key of a program from its sources and the driver that compiles it:
+    // binaries are only valid for the same vendor, renderer and version
+    uint64_t ProgramCacheKey(const std::string &vertex_source, const std::string &fragment_source);
+
+    // Load a program saved under 'key' into 'program'; returns false if
+    // there is no such file. The driver may still reject the binary,
+    // which shows as a failed link
+    bool LoadProgramBinary(const std::string &filename, uint64_t key, GLuint program);
+    // Save a linked program; failures only mean it is compiled next time
+    void SaveProgramBinary(const std::string &filename, uint64_t key, GLuint program);
+
+} // namespace game
+
+#endif // PROGRAM_CACHE_H_
@@ -0,0 +1,156 @@
+#define GLM_FORCE_RADIANS
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "projectile_system.h"
+
+namespace game {
+
+ProjectileSystem::ProjectileSystem(const std::string name, const Resource *geometry, const Resource *material, const Resource *texture, int capacity, float radius) : InstancedNode(name, geometry, material, texture) {
+
+    capacity_ = capacity;
+    live_num_ = 0;
+    radius_ = radius;
+    world_ = NULL;
+
+    // Everything the pool will ever need, allocated once
+    position_.resize(capacity);
+    velocity_.resize(capacity);
+    life_.resize(capacity);
+    shooter_.resize(capacity);
+    mask_.resize(capacity);
+    matrix_.resize(capacity);
+    query_.resize(capacity);
+    sweep_hit_.resize(capacity);
+    hit_.reserve(capacity);
+
+    glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+
+ProjectileSystem::~ProjectileSystem(){
+}
+
+
+void ProjectileSystem::SetCollisionWorld(CollisionWorld *world){
+
+    world_ = world;
+}
+
+
+bool ProjectileSystem::Fire(glm::vec3 position, glm::vec3 velocity, int life, int shooter, unsigned int mask){
+
+    if (live_num_ == capacity_){
+        return false;
+    }
+    int i = live_num_++;
+    position_[i] = position;
+    velocity_[i] = velocity;
+    life_[i] = life;
+    shooter_[i] = shooter;
+    mask_[i] = mask;
+    return true;
+}
+
+
+void ProjectileSystem::Update(void){
+
+    hit_.clear();
+
+    // Sweep every projectile over the tick in one batch, so fast ones
+    // cannot pass through their targets
+    if (world_ && live_num_){
+        for (int i = 0; i < live_num_; i++){
+            query_[i].start = position_[i];
+            query_[i].displacement = velocity_[i];
+            query_[i].radius = radius_;
+            query_[i].mask = mask_[i];
+            query_[i].overlaps = true;
+        }
+        if (world_->SweepBatch(&query_[0], live_num_, &sweep_hit_[0])){
+            // Projectiles that hit end with this tick
+            for (int i = 0; i < live_num_; i++){
+                if (sweep_hit_[i].body.IsValid()){
+                    ProjectileHit hit;
+                    hit.shooter = shooter_[i];
+                    hit.body = sweep_hit_[i].body;
+                    hit.point = sweep_hit_[i].point;
+                    hit_.push_back(hit);
+                    life_[i] = 0;
+                }
+            }
+        }
+    }
+
+    // Advance all and drop the expired ones; walking backwards, removing
+    // a projectile only moves one that was already checked
+    for (int i = 0; i < live_num_; i++){
+        position_[i] += velocity_[i];
+        life_[i]--;
+    }
+    for (int i = live_num_ - 1; i >= 0; i--){
+        if (life_[i] <= 0){
+            Remove(i);
+        }
+    }
+}
+
+
+const std::vector<ProjectileHit> &ProjectileSystem::GetHits(void) const {
+
+    return hit_;
+}
+
+
+int ProjectileSystem::GetLiveCount(void) const {
+
+    return live_num_;
+}
+
+
+int ProjectileSystem::GetCapacity(void) const {
+
+    return capacity_;
+}
+
+
+void ProjectileSystem::Remove(int index){
+
+    int last = --live_num_;
+    position_[index] = position_[last];
+    velocity_[index] = velocity_[last];
+    life_[index] = life_[last];
+    shooter_[index] = shooter_[last];
+    mask_[index] = mask_[last];
+}
+
+
+void ProjectileSystem::DrawBound(void){
+
+    if (!live_num_){
+        return;
+    }
+
+    // Projectiles are spheres: position and size are enough
+    for (int i = 0; i < live_num_; i++){
+        glm::mat4 &matrix = matrix_[i];
+        matrix = glm::mat4(radius_);
+        matrix[3] = glm::vec4(position_[i], 1.0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, live_num_ * sizeof(glm::mat4), glm::value_ptr(matrix_[0]));
+
+    // Transformation of the whole pool
+    glUniformMatrix4fv(locations_->world_mat, 1, GL_FALSE, glm::value_ptr(world_matrix_));
+    glUniformMatrix4fv(locations_->normal_mat, 1, GL_FALSE, glm::value_ptr(normal_matrix_));
+
+    if (mode_ == GL_POINTS){
+        glDrawArraysInstanced(mode_, 0, size_, live_num_);
+    } else {
+        glDrawElementsInstanced(mode_, size_, GL_UNSIGNED_INT, 0, live_num_);
+    }
+}
+
+} // namespace game
@@ -0,0 +1,84 @@
+#ifndef PROJECTILE_SYSTEM_H_
+#define PROJECTILE_SYSTEM_H_
+
+#include <string>
+#include <vector>
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include "resource.h"
+#include "instanced_node.h"
+#include "collision_world.h"
+
+namespace game {
+
+    // A projectile that hit a body in the last update
+    struct ProjectileHit {
+        int shooter;
+        BodyHandle body;
+        glm::vec3 point;
+    };
+
+    // All projectiles of the game in one fixed-size pool, drawn with a
+    // single instanced draw of one mesh
+    // Each attribute is an array over the pool, and the live projectiles
+    // are kept at the front, so updates and uploads walk memory in order
+    // and firing or expiring a projectile never allocates
+    class ProjectileSystem : public InstancedNode {
+
+        public:
+            // Create a pool of 'capacity' projectiles drawn as copies of
+            // 'geometry' scaled to 'radius'; use an instanced material
+            ProjectileSystem(const std::string name, const Resource *geometry, const Resource *material, const Resource *texture, int capacity, float radius);
+
+            // Destructor
+            ~ProjectileSystem();
+
+            // Bodies projectiles are swept against; none by default
+            void SetCollisionWorld(CollisionWorld *world);
+
+            // Fire a projectile moving by 'velocity' per tick for 'life'
+            // ticks, hitting the bodies of the layers in 'mask'. Returns
+            // false if the pool is full
+            bool Fire(glm::vec3 position, glm::vec3 velocity, int life, int shooter, unsigned int mask);
+
+            // Move all projectiles by one tick; projectiles that hit a body
+            // or run out of life are removed
+            void Update(void);
+            // Hits of the last update
+            const std::vector<ProjectileHit> &GetHits(void) const;
+
+            int GetLiveCount(void) const;
+            int GetCapacity(void) const;
+
+            // Upload the live projectiles and draw them
+            void DrawBound(void);
+
+        private:
+            int capacity_;
+            int live_num_;
+            float radius_;
+            // Attributes of the projectiles, live ones first
+            std::vector<glm::vec3> position_;
+            std::vector<glm::vec3> velocity_;
+            std::vector<int> life_;
+            std::vector<int> shooter_;
+            std::vector<unsigned int> mask_;
+            // World matrices of the live projectiles
+            std::vector<glm::mat4> matrix_;
+            // Sweeps of one update, and their results
+            std::vector<SweepQuery> query_;
+            std::vector<SweepHit> sweep_hit_;
+            std::vector<ProjectileHit> hit_;
+            CollisionWorld *world_;
+
+            // Move the last live projectile into slot 'index'
+            void Remove(int index);
+
+    }; // class ProjectileSystem
+
+} // namespace game
+
+#endif // PROJECTILE_SYSTEM_H_
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <cstring>
+
+#include "render_queue.h"
+
+namespace game {
+
+RenderQueue::RenderQueue(void){
+
+    draw_count_ = 0;
+    state_changes_ = 0;
+}
+
+
+RenderQueue::~RenderQueue(){
+}
+
+
+void RenderQueue::Clear(void){
+
+    item_.clear();
+}
+
+
+void RenderQueue::Push(SceneNode *node, float depth){
+
+    DrawItem item;
+    item.key = MakeKey(node->GetMaterial(), node->GetTexture(), node->GetVertexArray(), depth);
+    item.node = node;
+    item_.push_back(item);
+}
+
+
+void RenderQueue::Sort(void){
+
+    std::sort(item_.begin(), item_.end());
+}
+
+
+void RenderQueue::Submit(void){
+
+    GLuint program = 0;
+    GLuint texture = 0;
+    GLuint mesh = 0;
+    bool program_bound = false;
+    bool texture_bound = false;
+    bool mesh_bound = false;
+    draw_count_ = 0;
+    state_changes_ = 0;
+
+    for (int i = 0; i < item_.size(); i++){
+        SceneNode *node = item_[i].node;
+
+        // Material (shader program); per-frame globals live in the
+        // uniform buffer, so switching programs needs no uploads
+        if (!program_bound || node->GetMaterial() != program){
+            program = node->GetMaterial();
+            glUseProgram(program);
+            program_bound = true;
+            state_changes_++;
+        }
+
+        // Geometry
+        if (!mesh_bound || node->GetVertexArray() != mesh){
+            mesh = node->GetVertexArray();
+            node->BindGeometry();
+            mesh_bound = true;
+            state_changes_++;
+        }
+
+        // Texture
+        if (!texture_bound || node->GetTexture() != texture){
+            texture = node->GetTexture();
+            node->BindTexture();
+            texture_bound = true;
+            state_changes_++;
+        }
+
+        node->DrawBound();
+        draw_count_++;
+    }
+
+    // Leave no vertex array bound, so buffer setup elsewhere cannot
+    // change one by accident
+    glBindVertexArray(0);
+}
+
+
+int RenderQueue::GetDrawCount(void) const {
+
+    return draw_count_;
+}
+
+
+int RenderQueue::GetStateChanges(void) const {
+
+    return state_changes_;
+}
+
+
+unsigned long long RenderQueue::MakeKey(GLuint program, GLuint texture, GLuint mesh, float depth){
+
+    // The bit pattern of a non-negative float grows with its value, so its
+    // top bits give a coarse front-to-back order at any scale
+    if (!(depth > 0.0f)){
+        depth = 0.0f;
+    }
+    unsigned int depth_bits;
+    memcpy(&depth_bits, &depth, sizeof(depth_bits));
+
+    unsigned long long key = 0;
+    key |= ((unsigned long long) (program & 0xFFF)) << 52;
+    key |= ((unsigned long long) (texture & 0xFFFF)) << 36;
+    key |= ((unsigned long long) (mesh & 0xFFFF)) << 20;
+    key |= ((unsigned long long) (depth_bits >> 11)) & 0xFFFFF;
+    return key;
+}
+
+} // namespace game
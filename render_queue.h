@@ -0,0 +1,56 @@
+#ifndef RENDER_QUEUE_H_
+#define RENDER_QUEUE_H_
+
+#include <vector>
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "scene_node.h"
+
+namespace game {
+
+    // Collects the nodes to draw in a frame, sorts them by render state and
+    // submits them, changing OpenGL state only when it differs from the
+    // previous draw
+    class RenderQueue {
+
+        public:
+            // Constructor and destructor
+            RenderQueue(void);
+            ~RenderQueue();
+
+            // Remove all queued draws
+            void Clear(void);
+            // Queue a node at distance 'depth' from the camera
+            void Push(SceneNode *node, float depth);
+            // Order queued draws by program, texture, mesh and depth
+            void Sort(void);
+            // Draw all queued nodes
+            void Submit(void);
+
+            // Number of draws and state changes in the last submit
+            int GetDrawCount(void) const;
+            int GetStateChanges(void) const;
+
+        private:
+            // One queued draw
+            struct DrawItem {
+                unsigned long long key; // Packed sort key
+                SceneNode *node;
+                bool operator<(const DrawItem &other) const { return key < other.key; }
+            };
+            std::vector<DrawItem> item_;
+
+            int draw_count_;
+            int state_changes_;
+
+            // Pack program (12 bits), texture (16 bits), mesh (16 bits) and
+            // depth (20 bits) into one key, most expensive change first
+            static unsigned long long MakeKey(GLuint program, GLuint texture, GLuint mesh, float depth);
+
+    }; // class RenderQueue
+
+} // namespace game
+
+#endif // RENDER_QUEUE_H_
@@ -1,4 +1,7 @@
 #include <exception>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 #include "resource.h"
 
@@ -9,20 +12,51 @@ Resource::Resource(ResourceType type, std::string name, GLuint resource, GLsizei
     name_ = name;
     resource_ = resource;
     size_ = size;
+    locations_ = NULL;
+    bounds_.box_min = bounds_.box_max = bounds_.center = glm::vec3(0.0);
+    bounds_.radius = -1.0;
+    ready_ = true;
+    failed_ = false;
+    ref_count_ = 0;
+    bytes_ = 0;
 }
 
 
-Resource::Resource(ResourceType type, std::string name, GLuint array_buffer, GLuint element_array_buffer, GLsizei size){
+Resource::Resource(ResourceType type, std::string name, GLuint array_buffer, GLuint element_array_buffer, GLuint vertex_array, const VertexFormat &format, GLsizei size){
     type_ = type;
     name_ = name;
     array_buffer_ = array_buffer;
     element_array_buffer_ = element_array_buffer;
+    vertex_array_ = vertex_array;
+    format_ = format;
     size_ = size;
+    locations_ = NULL;
+    bounds_.box_min = bounds_.box_max = bounds_.center = glm::vec3(0.0);
+    bounds_.radius = -1.0;
+    ready_ = true;
+    failed_ = false;
+    ref_count_ = 0;
+    bytes_ = 0;
 }
 
 
 Resource::~Resource(){
 
+    delete locations_;
+
+    // Nothing to delete once the context is gone, at exit
+    if (!glfwGetCurrentContext()){
+        return;
+    }
+    if (type_ == Material){
+        glDeleteProgram(resource_);
+    } else if (type_ == Texture){
+        glDeleteTextures(1, &resource_);
+    } else {
+        glDeleteVertexArrays(1, &vertex_array_);
+        glDeleteBuffers(1, &array_buffer_);
+        glDeleteBuffers(1, &element_array_buffer_);
+    }
 }
 
 
@@ -56,9 +90,304 @@ GLuint Resource::GetElementArrayBuffer(void) const {
 }
 
 
+GLuint Resource::GetVertexArray(void) const {
+
+    return vertex_array_;
+}
+
+
+const VertexFormat &Resource::GetVertexFormat(void) const {
+
+    return format_;
+}
+
+
+void Resource::SetResource(GLuint resource){
+
+    resource_ = resource;
+}
+
+
+void Resource::SetGeometry(GLuint array_buffer, GLuint element_array_buffer, GLuint vertex_array, const VertexFormat &format, GLsizei size){
+
+    array_buffer_ = array_buffer;
+    element_array_buffer_ = element_array_buffer;
+    vertex_array_ = vertex_array;
+    format_ = format;
+    size_ = size;
+}
+
+
+bool Resource::IsReady(void) const {
+
+    return ready_;
+}
+
+
+void Resource::SetReady(bool ready){
+
+    ready_ = ready;
+}
+
+
+bool Resource::IsFailed(void) const {
+
+    return failed_;
+}
+
+
+void Resource::SetFailed(bool failed){
+
+    failed_ = failed;
+}
+
+
+void Resource::AddRef(void) const {
+
+    ref_count_++;
+}
+
+
+void Resource::Release(void) const {
+
+    ref_count_--;
+}
+
+
+int Resource::GetRefCount(void) const {
+
+    return ref_count_;
+}
+
+
+size_t Resource::GetBytes(void) const {
+
+    return bytes_;
+}
+
+
+void Resource::SetBytes(size_t bytes){
+
+    bytes_ = bytes;
+}
+
+
+// Offset of each attribute, in floats, in the generated layout
+static const int source_offset_g[4] = { 0, 3, 6, 9 };
+
+
+static VertexAttributeFormat MakeAttribute(GLint size, GLenum type, GLboolean normalized, GLuint offset){
+
+    VertexAttributeFormat attribute;
+    attribute.enabled = true;
+    attribute.size = size;
+    attribute.type = type;
+    attribute.normalized = normalized;
+    attribute.offset = offset;
+    return attribute;
+}
+
+
+VertexFormat FloatVertexFormat(void){
+
+    VertexFormat format;
+    for (int i = 0; i < 4; i++){
+        format.attribute[i] = MakeAttribute((i == UvAttribute) ? 2 : 3, GL_FLOAT, GL_FALSE, source_offset_g[i]*sizeof(GLfloat));
+    }
+    format.stride = VERTEX_ATTRIBUTES*sizeof(GLfloat);
+    return format;
+}
+
+
+VertexFormat PackedVertexFormat(bool color){
+
+    VertexFormat format;
+    format.attribute[VertexAttribute] = MakeAttribute(3, GL_FLOAT, GL_FALSE, 0);
+    if (GLEW_ARB_vertex_type_2_10_10_10_rev){
+        format.attribute[NormalAttribute] = MakeAttribute(4, GL_INT_2_10_10_10_REV, GL_TRUE, 12);
+    } else {
+        format.attribute[NormalAttribute] = MakeAttribute(4, GL_BYTE, GL_TRUE, 12);
+    }
+    format.attribute[UvAttribute] = MakeAttribute(2, GL_HALF_FLOAT, GL_FALSE, 16);
+    format.attribute[ColorAttribute] = MakeAttribute(4, GL_UNSIGNED_BYTE, GL_TRUE, 20);
+    format.attribute[ColorAttribute].enabled = color;
+    format.stride = color ? 24 : 20;
+    return format;
+}
+
+
+// Convert a float to IEEE half precision, rounding to nearest
+static GLushort FloatToHalf(float value){
+
+    GLuint bits;
+    memcpy(&bits, &value, sizeof(bits));
+    GLuint sign = (bits >> 16) & 0x8000;
+    int exponent = (int) ((bits >> 23) & 0xff) - 127 + 15;
+    GLuint mantissa = bits & 0x7fffff;
+
+    if (exponent >= 31){
+        // Too large, infinity or NaN
+        return (GLushort) (sign | 0x7c00 | (((bits & 0x7fffffff) > 0x7f800000) ? 0x200 : 0));
+    }
+    if (exponent <= 0){
+        // Denormal or zero
+        if (exponent < -10){
+            return (GLushort) sign;
+        }
+        mantissa |= 0x800000;
+        GLuint shift = 14 - exponent;
+        GLuint half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1){
+            half++;
+        }
+        return (GLushort) (sign | half);
+    }
+    GLuint half = sign | (exponent << 10) | (mantissa >> 13);
+    // Round; a carry into the exponent is still correct
+    if (mantissa & 0x1000){
+        half++;
+    }
+    return (GLushort) half;
+}
+
+
+// Signed normalized integer of 'bits' bits
+static int FloatToSnorm(float value, int bits){
+
+    float max = (float) ((1 << (bits - 1)) - 1);
+    value = std::min(std::max(value, -1.0f), 1.0f);
+    return (int) floor(value*max + 0.5f);
+}
+
+
+void PackVertices(const std::vector<GLfloat> &vertex, const VertexFormat &format, std::vector<unsigned char> &packed){
+
+    size_t vertex_num = vertex.size() / VERTEX_ATTRIBUTES;
+    packed.assign(vertex_num * format.stride, 0);
+
+    for (size_t v = 0; v < vertex_num; v++){
+        const GLfloat *source = &vertex[v*VERTEX_ATTRIBUTES];
+        unsigned char *dest = &packed[v*format.stride];
+        for (int a = 0; a < 4; a++){
+            const VertexAttributeFormat &attribute = format.attribute[a];
+            if (!attribute.enabled){
+                continue;
+            }
+            const GLfloat *in = source + source_offset_g[a];
+            glm::vec3 value(in[0], in[1], (a == UvAttribute) ? 0.0f : in[2]);
+            // Normals are stored with unit length
+            if ((a == NormalAttribute) && (glm::length(value) > 0.0)){
+                value = glm::normalize(value);
+            }
+            unsigned char *out = dest + attribute.offset;
+            switch (attribute.type){
+                case GL_FLOAT:
+                    memcpy(out, &value[0], attribute.size*sizeof(GLfloat));
+                    break;
+                case GL_HALF_FLOAT:
+                    for (int i = 0; i < attribute.size; i++){
+                        GLushort half = FloatToHalf(value[i]);
+                        memcpy(out + i*sizeof(GLushort), &half, sizeof(GLushort));
+                    }
+                    break;
+                case GL_INT_2_10_10_10_REV: {
+                    // x in the low bits, w (unused) in the top two
+                    GLuint word = (FloatToSnorm(value.x, 10) & 0x3ff) |
+                                  ((FloatToSnorm(value.y, 10) & 0x3ff) << 10) |
+                                  ((FloatToSnorm(value.z, 10) & 0x3ff) << 20);
+                    memcpy(out, &word, sizeof(GLuint));
+                    break;
+                }
+                case GL_BYTE:
+                    for (int i = 0; i < 3; i++){
+                        out[i] = (unsigned char) (signed char) FloatToSnorm(value[i], 8);
+                    }
+                    break;
+                case GL_UNSIGNED_BYTE:
+                    for (int i = 0; i < 3; i++){
+                        out[i] = (unsigned char) floor(std::min(std::max(value[i], 0.0f), 1.0f)*255.0f + 0.5f);
+                    }
+                    out[3] = 255;
+                    break;
+            }
+        }
+    }
+}
+
+
+void SetupVertexAttributes(const VertexFormat &format){
+
+    for (int i = 0; i < 4; i++){
+        const VertexAttributeFormat &attribute = format.attribute[i];
+        if (attribute.enabled){
+            glVertexAttribPointer(i, attribute.size, attribute.type, attribute.normalized, format.stride, (void *) (size_t) attribute.offset);
+            glEnableVertexAttribArray(i);
+        } else {
+            glDisableVertexAttribArray(i);
+        }
+    }
+}
+
+
 GLsizei Resource::GetSize(void) const {
 
     return size_;
 }
 
+
+const ShaderLocations *Resource::GetLocations(void) const {
+
+    return locations_;
+}
+
+
+void Resource::SetLocations(ShaderLocations *locations){
+
+    delete locations_;
+    locations_ = locations;
+}
+
+
+const Bounds &Resource::GetBounds(void) const {
+
+    return bounds_;
+}
+
+
+void Resource::SetBounds(const Bounds &bounds){
+
+    bounds_ = bounds;
+}
+
+
+Bounds ComputeBounds(const GLfloat *data, int count, int stride){
+
+    Bounds bounds;
+    if (count <= 0){
+        bounds.box_min = bounds.box_max = bounds.center = glm::vec3(0.0);
+        bounds.radius = -1.0;
+        return bounds;
+    }
+
+    // Box enclosing all positions
+    bounds.box_min = bounds.box_max = glm::vec3(data[0], data[1], data[2]);
+    for (int i = 1; i < count; i++){
+        glm::vec3 p(data[i*stride], data[i*stride + 1], data[i*stride + 2]);
+        bounds.box_min = glm::min(bounds.box_min, p);
+        bounds.box_max = glm::max(bounds.box_max, p);
+    }
+
+    // Sphere around the center of the box, with the radius of the
+    // farthest position, which is tighter than half the box diagonal
+    bounds.center = 0.5f*(bounds.box_min + bounds.box_max);
+    float radius2 = 0.0;
+    for (int i = 0; i < count; i++){
+        glm::vec3 d = glm::vec3(data[i*stride], data[i*stride + 1], data[i*stride + 2]) - bounds.center;
+        radius2 = std::max(radius2, glm::dot(d, d));
+    }
+    bounds.radius = sqrt(radius2);
+
+    return bounds;
+}
+
 } // namespace game
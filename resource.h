@@ -2,14 +2,72 @@
 #define RESOURCE_H_
 
 #include <string>
+#include <vector>
 #define GLEW_STATIC
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include "shader_locations.h"
 
 namespace game {
 
     // Possible resource types
     typedef enum Type { Material, PointSet, Mesh, Texture } ResourceType;
+    #define NUM_RESOURCE_TYPES 4
+
+    // Vertex attribute locations shared by all shader programs, so one
+    // vertex array object per mesh works with any material
+    // The per-instance world matrix of instanced materials takes four
+    // consecutive locations
+    typedef enum Attribute { VertexAttribute = 0, NormalAttribute = 1, ColorAttribute = 2, UvAttribute = 3, InstanceAttribute = 4 } AttributeLocation;
+
+    // Number of floats per vertex of the layout meshes are generated in:
+    // 3D position (3), 3D normal (3), RGB color (3), 2D texture
+    // coordinates (2)
+    #define VERTEX_ATTRIBUTES 11
+
+    // Storage of one vertex attribute in an interleaved vertex buffer
+    struct VertexAttributeFormat {
+        bool enabled; // Disabled attributes read the default value (0, 0, 0, 1)
+        GLint size; // Number of components
+        GLenum type; // GL_FLOAT, GL_HALF_FLOAT, GL_INT_2_10_10_10_REV, ...
+        GLboolean normalized; // Integer components map to [-1, 1] or [0, 1]
+        GLuint offset; // Offset in bytes from the start of the vertex
+    };
+
+    // Layout of the vertices of a mesh, indexed by AttributeLocation
+    struct VertexFormat {
+        VertexAttributeFormat attribute[4];
+        GLsizei stride; // Size of one vertex in bytes
+    };
+
+    // 11 floats per vertex, as meshes are generated (44 bytes)
+    VertexFormat FloatVertexFormat(void);
+    // Float position, normal packed in 10-10-10-2 (or bytes when the
+    // packed type is not supported), half-float texture coordinates and,
+    // optionally, an 8-bit color: 20 bytes, or 24 with color
+    VertexFormat PackedVertexFormat(bool color);
+
+    // Convert vertices from the generated layout to 'format'
+    void PackVertices(const std::vector<GLfloat> &vertex, const VertexFormat &format, std::vector<unsigned char> &packed);
+
+    // Set the attribute pointers of a vertex format for the array buffer
+    // currently bound
+    void SetupVertexAttributes(const VertexFormat &format);
+
+    // Bounding volumes of a mesh in object coordinates
+    // A negative radius means the extent is unknown
+    struct Bounds {
+        glm::vec3 box_min; // Axis-aligned bounding box
+        glm::vec3 box_max;
+        glm::vec3 center; // Bounding sphere
+        float radius;
+    };
+
+    // Compute the bounds of 'count' positions stored every 'stride'
+    // floats in 'data'
+    Bounds ComputeBounds(const GLfloat *data, int count, int stride);
 
     // Class that holds one resource
     class Resource {
@@ -24,20 +82,64 @@ namespace game {
                 struct {
                     GLuint array_buffer_; // Buffers for geometry
                     GLuint element_array_buffer_;
+                    GLuint vertex_array_; // Attribute layout of the buffers
                 };
             };
             GLsizei size_; // Number of primitives in geometry
+            ShaderLocations *locations_; // Input locations of a material
+            Bounds bounds_; // Extent of a geometry
+            VertexFormat format_; // Vertex layout of a geometry
+            bool ready_; // False while a placeholder stands in for the data
+            bool failed_; // The data could not be loaded; the placeholder stays
+            mutable int ref_count_; // Number of scene nodes using the resource
+            size_t bytes_; // Memory taken by the OpenGL objects
+
+            // The OpenGL objects are deleted with the resource, so it is
+            // not copied
+            Resource(const Resource &);
+            Resource &operator=(const Resource &);
 
         public:
             Resource(ResourceType type, std::string name, GLuint resource, GLsizei size);
-            Resource(ResourceType type, std::string name, GLuint array_buffer, GLuint element_array_buffer, GLsizei size);
+            Resource(ResourceType type, std::string name, GLuint array_buffer, GLuint element_array_buffer, GLuint vertex_array, const VertexFormat &format, GLsizei size);
+            // Deletes the OpenGL objects of the resource, if the context
+            // still exists
             ~Resource();
             ResourceType GetType(void) const;
             const std::string GetName(void) const;
             GLuint GetResource(void) const;
             GLuint GetArrayBuffer(void) const;
             GLuint GetElementArrayBuffer(void) const;
+            GLuint GetVertexArray(void) const;
+            const VertexFormat &GetVertexFormat(void) const;
             GLsizei GetSize(void) const;
+            // Replace the OpenGL objects, when data loaded in the
+            // background replaces a placeholder
+            void SetResource(GLuint resource);
+            void SetGeometry(GLuint array_buffer, GLuint element_array_buffer, GLuint vertex_array, const VertexFormat &format, GLsizei size);
+            // Whether the actual data is in place; scene nodes refresh
+            // their copies of the objects once it is
+            bool IsReady(void) const;
+            void SetReady(bool ready);
+            // Whether a background load of the data failed; the resource
+            // is then never ready
+            bool IsFailed(void) const;
+            void SetFailed(bool failed);
+            // References held by users of the resource; the manager only
+            // frees unloaded resources once nothing refers to them
+            void AddRef(void) const;
+            void Release(void) const;
+            int GetRefCount(void) const;
+            // Estimated memory of the OpenGL objects, kept up to date by
+            // the manager for its accounting
+            size_t GetBytes(void) const;
+            void SetBytes(size_t bytes);
+            // Cached attribute and uniform locations of a material
+            const ShaderLocations *GetLocations(void) const;
+            void SetLocations(ShaderLocations *locations);
+            // Extent of a geometry, computed when it is created
+            const Bounds &GetBounds(void) const;
+            void SetBounds(const Bounds &bounds);
 
     }; // class Resource
 
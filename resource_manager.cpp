@@ -1,132 +1,947 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 #include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+#include <memory>
 #include <SOIL/SOIL.h>
 
 #include "resource_manager.h"
+#include "frame_globals.h"
 #include "model_loader.h"
+#include "mesh_optimizer.h"
+#include "mesh_cache.h"
+#include "resource_manifest.h"
+#include "program_cache.h"
+#include "texture_container.h"
 
 namespace game {
 
+// Memory of an RGBA8 texture with its full mipmap chain
+static size_t TextureBytes(int width, int height){
+
+    size_t bytes = 0;
+    while (true){
+        bytes += (size_t) width * height * 4;
+        if ((width == 1) && (height == 1)){
+            break;
+        }
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+    return bytes;
+}
+
+
 ResourceManager::ResourceManager(void){
+
+    sampler_ = 0;
+    optimize_overdraw_ = true;
+    verbose_ = false;
+    compiler_context_ = NULL;
+    placeholder_texture_ = 0;
+    pending_loads_ = 0;
+    for (int i = 0; i < NUM_RESOURCE_TYPES; i++){
+        resident_bytes_[i] = 0;
+    }
 }
 
 
 ResourceManager::~ResourceManager(){
+
+    // Workers refer to the manager: wait for them first
+    loader_.Stop();
+
+    // Uploads that never ran free their decoded data as they go
+    upload_.clear();
+
+    // Free every resource, used or not
+    for (int i = 0; i < slot_.size(); i++){
+        if (slot_[i].resource){
+            DeleteResource(slot_[i].resource);
+        }
+    }
+    for (int i = 0; i < unloaded_.size(); i++){
+        DeleteResource(unloaded_[i]);
+    }
+
+    if (glfwGetCurrentContext()){
+        glDeleteTextures(1, &placeholder_texture_);
+        if (sampler_){
+            glDeleteSamplers(1, &sampler_);
+        }
+    }
 }
 
 
-void ResourceManager::AddResource(ResourceType type, const std::string name, GLuint resource, GLsizei size){
+Resource *ResourceManager::AddResource(ResourceType type, const std::string name, GLuint resource, GLsizei size){
 
     Resource *res;
 
     res = new Resource(type, name, resource, size);
 
-    resource_.push_back(res);
+    RegisterResource(res);
+
+    return res;
+}
+
+
+Resource *ResourceManager::AddResource(ResourceType type, const std::string name, GLuint array_buffer, GLuint element_array_buffer, const VertexFormat &format, GLsizei size){
+
+    Resource *res;
+
+    // Attribute setup is done once here instead of on every draw
+    GLuint vertex_array = CreateVertexArray(array_buffer, element_array_buffer, format);
+
+    res = new Resource(type, name, array_buffer, element_array_buffer, vertex_array, format, size);
+
+    RegisterResource(res);
+
+    return res;
+}
+
+
+void ResourceManager::LoadResource(ResourceType type, const std::string name, const char *filename){
+
+    // Call appropriate method depending on type of resource
+    if (type == Material){
+        LoadMaterial(name, filename);
+    } else if (type == Texture){
+        LoadTexture(name, filename);
+    } else if (type == Mesh){
+        LoadMesh(name, filename);
+    } else {
+        throw(std::invalid_argument(std::string("Invalid type of resource")));
+    }
+}
+
+
+Resource *ResourceManager::LoadResourceAsync(ResourceType type, const std::string name, const char *filename){
+
+    // Shader programs are built with the context all along, and their
+    // sources are small: load them at once
+    if (type == Material){
+        LoadMaterial(name, filename);
+        return GetResource(name);
+    }
+    if ((type != Texture) && (type != Mesh)){
+        throw(std::invalid_argument(std::string("Invalid type of resource")));
+    }
+
+    Resource *res = CreatePlaceholder(type, name);
+    StartBackgroundLoad(res, filename);
+    return res;
+}
+
+
+Resource *ResourceManager::CreatePlaceholder(ResourceType type, const std::string name){
+
+    // The resource exists from now on, with a placeholder the scene can
+    // already use
+    Resource *res;
+    if (type == Texture){
+        res = new Resource(Texture, name, GetPlaceholderTexture(), 0);
+    } else {
+        VertexFormat format;
+        memset(&format, 0, sizeof(format));
+        res = new Resource(Mesh, name, 0, 0, 0, format, 0);
+    }
+    res->SetReady(false);
+    RegisterResource(res);
+    return res;
+}
+
+
+void ResourceManager::StartBackgroundLoad(Resource *res, const std::string filename){
+
+    // Workers are created with the first request, leaving one core to
+    // the main thread
+    if (!loader_.IsStarted()){
+        int thread_num = std::thread::hardware_concurrency();
+        loader_.Start(std::max(thread_num - 1, 1));
+    }
+
+    pending_loads_++;
+    if (res->GetType() == Texture){
+        loader_.Submit([this, res, filename](){ ReadTextureAsync(res, filename); });
+    } else {
+        loader_.Submit([this, res, filename](){ ReadMeshAsync(res, filename); });
+    }
+}
+
+
+void ResourceManager::LoadManifest(const char *filename){
+
+    std::vector<ManifestItem> item;
+    LoadManifestFile(filename, item);
+    for (unsigned int i = 0; i < item.size(); i++){
+        if (manifest_.find(item[i].name) != manifest_.end()){
+            throw(std::ios_base::failure(std::string("Error: ")+item[i].name+std::string(" in ")+std::string(filename)+std::string(" is already in another manifest")));
+        }
+    }
+    for (unsigned int i = 0; i < item.size(); i++){
+        manifest_[item[i].name] = item[i];
+    }
+
+    // Lazy items wait for their first lookup
+    for (unsigned int i = 0; i < item.size(); i++){
+        if (!item[i].lazy){
+            RequestManifestItem(item[i].name);
+        }
+    }
+    StartManifestItems();
+}
+
+
+void ResourceManager::RequestManifestItem(const std::string name){
+
+    ManifestItem &item = manifest_[name];
+    if (item.state != ManifestIdle){
+        return;
+    }
+    item.state = ManifestWaiting;
+
+    // Everything the item needs is loaded too, even if lazy
+    for (unsigned int i = 0; i < item.dependency.size(); i++){
+        RequestManifestItem(item.dependency[i]);
+    }
+
+    // Files get their placeholder now, so lookups find them while they
+    // wait for their dependencies
+    if (item.kind == "texture"){
+        CreatePlaceholder(Texture, name);
+    } else if (item.kind == "mesh"){
+        CreatePlaceholder(Mesh, name);
+    }
+    manifest_waiting_.push_back(name);
+}
+
+
+void ResourceManager::StartManifestItems(void){
+
+    // Items built at once make their dependents ready, so repeat until
+    // nothing else can start
+    bool started = true;
+    while (started){
+        started = false;
+        for (unsigned int i = 0; i < manifest_waiting_.size(); ){
+            ManifestItem &item = manifest_[manifest_waiting_[i]];
+            bool ready = true;
+            for (unsigned int j = 0; (j < item.dependency.size()) && ready; j++){
+                std::unordered_map<std::string, unsigned int>::const_iterator it = index_.find(item.dependency[j]);
+                ready = (it != index_.end()) && slot_[it->second].resource->IsReady();
+            }
+            if (!ready){
+                i++;
+                continue;
+            }
+            manifest_waiting_[i] = manifest_waiting_.back();
+            manifest_waiting_.pop_back();
+            StartManifestItem(item);
+            started = true;
+        }
+
+        // Programs begun in this pass compiled side by side; wait for them
+        // now, so the items that depend on them can start
+        FinishMaterials();
+    }
+}
+
+
+void ResourceManager::StartManifestItem(ManifestItem &item){
+
+    item.state = ManifestStarted;
+
+    // Files are read on the workers; programs and generated meshes are
+    // built here, generated ones usually from the mesh cache
+    if ((item.kind == "texture") || (item.kind == "mesh")){
+        std::unordered_map<std::string, unsigned int>::const_iterator it = index_.find(item.name);
+        if (it != index_.end()){
+            StartBackgroundLoad(slot_[it->second].resource, GetManifestPath(item, 0));
+        }
+    } else if (item.kind == "material"){
+        BeginMaterial(item.name, GetManifestPath(item, 0).c_str(), VERTEX_PROGRAM_EXTENSION);
+    } else if (item.kind == "instanced_material"){
+        BeginMaterial(item.name, GetManifestPath(item, 0).c_str(), INSTANCED_VERTEX_PROGRAM_EXTENSION);
+    } else if (item.kind == "torus"){
+        CreateTorus(item.name, GetManifestNumber(item, 0, 0.6), GetManifestNumber(item, 1, 0.2), (int) GetManifestNumber(item, 2, 90), (int) GetManifestNumber(item, 3, 30));
+    } else if (item.kind == "sphere"){
+        CreateSphere(item.name, GetManifestNumber(item, 0, 0.6), (int) GetManifestNumber(item, 1, 90), (int) GetManifestNumber(item, 2, 45));
+    } else if (item.kind == "cylinder"){
+        CreateCylinder(item.name, glm::vec3(GetManifestNumber(item, 0, 1.0), GetManifestNumber(item, 1, 1.0), GetManifestNumber(item, 2, 1.0)));
+    } else if (item.kind == "plane"){
+        CreatePlane(item.name, glm::vec3(GetManifestNumber(item, 0, 1.0), GetManifestNumber(item, 1, 1.0), GetManifestNumber(item, 2, 1.0)));
+    }
+}
+
+
+void ResourceManager::LoadLazyItem(const std::string name){
+
+    if (index_.find(name) != index_.end()){
+        return;
+    }
+    std::unordered_map<std::string, ManifestItem>::iterator it = manifest_.find(name);
+    if ((it == manifest_.end()) || (it->second.state != ManifestIdle)){
+        return;
+    }
+
+    // Queued behind its dependencies like any other item; files have
+    // their placeholder at once, built items exist once they can start
+    RequestManifestItem(name);
+    StartManifestItems();
+}
+
+
+int ResourceManager::ProcessUploads(double time_budget){
+
+    // Start manifest items whose dependencies became ready
+    if (!manifest_waiting_.empty()){
+        StartManifestItems();
+    }
+
+    double start = glfwGetTime();
+    int count = 0;
+    while (true){
+        std::function<void(void)> upload;
+        {
+            std::lock_guard<std::mutex> lock(upload_mutex_);
+            if (upload_.empty()){
+                break;
+            }
+            upload = upload_.front();
+            upload_.pop_front();
+        }
+        pending_loads_--;
+        upload();
+        count++;
+
+        // Leave the rest for the next frames
+        if ((glfwGetTime() - start) >= time_budget){
+            break;
+        }
+    }
+
+    // Finer texture levels with the time left
+    count += StreamTextures(time_budget - (glfwGetTime() - start));
+    return count;
+}
+
+
+int ResourceManager::GetPendingLoads(void) const {
+
+    return pending_loads_ + manifest_waiting_.size() + streaming_.size();
+}
+
+
+void ResourceManager::QueueUpload(std::function<void(void)> upload){
+
+    std::lock_guard<std::mutex> lock(upload_mutex_);
+    upload_.push_back(upload);
+}
+
+
+void ResourceManager::ReadTextureAsync(Resource *res, const std::string filename){
+
+    // A texture container is mapped here and streamed by the main thread
+    std::shared_ptr<StreamedTexture> texture(new StreamedTexture);
+    if (ReadTextureStream(filename, *texture)){
+        QueueUpload([this, res, texture](){ StartTextureStream(res, texture); });
+        return;
+    }
+
+    // Decode on the worker; errors are raised on the main thread, like
+    // those of synchronous loads. SOIL_last_result() is shared by all
+    // threads, so the message cannot tell why
+    int width, height, channels;
+    unsigned char *data = SOIL_load_image(filename.c_str(), &width, &height, &channels, SOIL_LOAD_RGBA);
+    if (!data){
+        std::string message = std::string("Error loading texture ")+filename+std::string(": could not read or decode the image");
+        QueueUpload([this, res, message](){
+            FailLoad(res);
+            throw(std::ios_base::failure(message));
+        });
+        return;
+    }
+
+    // The pixels are freed with the upload, even if it never runs
+    std::shared_ptr<unsigned char> image(data, SOIL_free_image_data);
+    QueueUpload([this, res, image, width, height](){
+        res->SetResource(CreateTexture(image.get(), width, height));
+        SetResourceBytes(res, TextureBytes(width, height));
+        res->SetReady(true);
+    });
+}
+
+
+void ResourceManager::ReadMeshAsync(Resource *res, const std::string filename){
+
+    try {
+        // The mapped cache file, if current, is uploaded as it is
+        uint64_t stamp = HashFileStamp(filename.c_str(), 0);
+        uint64_t key = MeshCacheKey(filename.c_str(), &stamp, sizeof(stamp));
+        std::string path = GetMeshCachePath(res->GetName());
+        std::shared_ptr<CachedMesh> cached(new CachedMesh);
+        if (stamp && !path.empty() && ReadMeshCache(path, key, *cached)){
+            QueueUpload([this, res, cached](){
+                FillMesh(res, cached->format, cached->bounds, cached->vertex, cached->vertex_size, cached->face, cached->index_num);
+            });
+            return;
+        }
+
+        // Otherwise parse and process the mesh here
+        std::vector<GLfloat> vertex;
+        std::vector<GLuint> face;
+        ReadMesh(filename.c_str(), vertex, face);
+        std::shared_ptr<PackedMesh> mesh(new PackedMesh);
+        ProcessMesh(res->GetName(), vertex, face, stamp ? key : 0, *mesh);
+        QueueUpload([this, res, mesh](){
+            ReportMesh(res->GetName(), *mesh);
+            FillMesh(res, mesh->format, mesh->bounds, mesh->vertex.empty() ? NULL : &mesh->vertex[0], mesh->vertex.size(), mesh->face.empty() ? NULL : &mesh->face[0], mesh->face.size());
+        });
+    }
+    catch (std::exception &e){
+        std::string message(e.what());
+        QueueUpload([this, res, message](){
+            FailLoad(res);
+            throw(std::ios_base::failure(message));
+        });
+    }
+}
+
+
+void ResourceManager::FailLoad(Resource *res){
+
+    res->SetFailed(true);
+
+    // The manifest item of the resource, if any, will never be ready
+    std::unordered_map<std::string, ManifestItem>::iterator it = manifest_.find(res->GetName());
+    if ((it != manifest_.end()) && (it->second.state == ManifestStarted)){
+        it->second.state = ManifestFailed;
+    }
+
+    // Neither will the items waiting for it, nor those waiting for them
+    bool failed = true;
+    while (failed){
+        failed = false;
+        for (unsigned int i = 0; i < manifest_waiting_.size(); ){
+            ManifestItem &item = manifest_[manifest_waiting_[i]];
+            bool blocked = false;
+            for (unsigned int j = 0; (j < item.dependency.size()) && !blocked; j++){
+                blocked = manifest_[item.dependency[j]].state == ManifestFailed;
+            }
+            if (!blocked){
+                i++;
+                continue;
+            }
+            manifest_waiting_[i] = manifest_waiting_.back();
+            manifest_waiting_.pop_back();
+            item.state = ManifestFailed;
+            std::unordered_map<std::string, unsigned int>::const_iterator placeholder = index_.find(item.name);
+            if ((placeholder != index_.end()) && !slot_[placeholder->second].resource->IsReady()){
+                slot_[placeholder->second].resource->SetFailed(true);
+            }
+            failed = true;
+        }
+    }
+}
+
+
+void ResourceManager::SetOverdrawOptimization(bool enable){
+
+    optimize_overdraw_ = enable;
+}
+
+
+void ResourceManager::SetVerbose(bool verbose){
+
+    verbose_ = verbose;
+}
+
+
+void ResourceManager::SetMeshCacheDirectory(const std::string directory){
+
+    mesh_cache_directory_ = directory;
+}
+
+
+void ResourceManager::SetProgramCacheDirectory(const std::string directory){
+
+    program_cache_directory_ = directory;
+}
+
+
+Resource *ResourceManager::GetResource(const std::string name){
+
+    // Load a lazy manifest item on first use
+    LoadLazyItem(name);
+
+    // Find resource with the specified name
+    std::unordered_map<std::string, unsigned int>::const_iterator it = index_.find(name);
+    if (it == index_.end()){
+        return NULL;
+    }
+    return slot_[it->second].resource;
+}
+
+
+MeshHandle ResourceManager::GetMeshHandle(const std::string name){
+
+    LoadLazyItem(name);
+
+    unsigned int index, generation;
+    if (!FindSlot(name, Mesh, index, generation)){
+        return MeshHandle();
+    }
+    return MeshHandle(index, generation);
+}
+
+
+MaterialHandle ResourceManager::GetMaterialHandle(const std::string name){
+
+    LoadLazyItem(name);
+
+    unsigned int index, generation;
+    if (!FindSlot(name, Material, index, generation)){
+        return MaterialHandle();
+    }
+    return MaterialHandle(index, generation);
+}
+
+
+TextureHandle ResourceManager::GetTextureHandle(const std::string name){
+
+    LoadLazyItem(name);
+
+    unsigned int index, generation;
+    if (!FindSlot(name, Texture, index, generation)){
+        return TextureHandle();
+    }
+    return TextureHandle(index, generation);
+}
+
+
+Resource *ResourceManager::GetResource(MeshHandle handle) const {
+
+    return ResolveSlot(handle.GetIndex(), handle.GetGeneration());
+}
+
+
+Resource *ResourceManager::GetResource(MaterialHandle handle) const {
+
+    return ResolveSlot(handle.GetIndex(), handle.GetGeneration());
+}
+
+
+Resource *ResourceManager::GetResource(TextureHandle handle) const {
+
+    return ResolveSlot(handle.GetIndex(), handle.GetGeneration());
+}
+
+
+void ResourceManager::RegisterResource(Resource *res){
+
+    // Reuse the slot of an unloaded resource; its generation was already
+    // bumped
+    unsigned int index;
+    if (!free_slot_.empty()){
+        index = free_slot_.back();
+        free_slot_.pop_back();
+        slot_[index].resource = res;
+    } else {
+        ResourceSlot slot;
+        slot.resource = res;
+        slot.generation = 1;
+        slot_.push_back(slot);
+        index = slot_.size() - 1;
+    }
+    resident_bytes_[res->GetType()] += res->GetBytes();
+
+    // Keep the first resource with a given name, like the old search did
+    index_.insert(std::make_pair(res->GetName(), index));
+}
+
+
+void ResourceManager::Unload(const std::string name){
+
+    std::unordered_map<std::string, unsigned int>::iterator it = index_.find(name);
+    if (it != index_.end()){
+        UnloadSlot(it->second);
+    }
+}
+
+
+void ResourceManager::Unload(MeshHandle handle){
+
+    if (GetResource(handle)){
+        UnloadSlot(handle.GetIndex());
+    }
+}
+
+
+void ResourceManager::Unload(MaterialHandle handle){
+
+    if (GetResource(handle)){
+        UnloadSlot(handle.GetIndex());
+    }
+}
+
+
+void ResourceManager::Unload(TextureHandle handle){
+
+    if (GetResource(handle)){
+        UnloadSlot(handle.GetIndex());
+    }
+}
+
+
+void ResourceManager::UnloadSlot(unsigned int index){
+
+    Resource *res = slot_[index].resource;
+
+    // Old handles stop resolving and the slot can be reused
+    slot_[index].resource = NULL;
+    slot_[index].generation++;
+    free_slot_.push_back(index);
+
+    // Forget the name, unless it refers to a resource in another slot;
+    // another resource with the same name takes it over
+    std::unordered_map<std::string, unsigned int>::iterator it = index_.find(res->GetName());
+    if ((it != index_.end()) && (it->second == index)){
+        index_.erase(it);
+        for (unsigned int i = 0; i < slot_.size(); i++){
+            if (slot_[i].resource && (slot_[i].resource->GetName() == res->GetName())){
+                index_.insert(std::make_pair(res->GetName(), i));
+                break;
+            }
+        }
+    }
+
+    // Freed now if nothing uses it, otherwise by a later purge
+    unloaded_.push_back(res);
+    Purge();
+}
+
+
+int ResourceManager::Purge(void){
+
+    int freed = 0;
+    for (int i = 0; i < unloaded_.size(); ){
+        // Wait until no node uses the resource and no background load
+        // writes to it; a failed load has nothing left to write
+        Resource *res = unloaded_[i];
+        if ((res->GetRefCount() > 0) || (!res->IsReady() && !res->IsFailed())){
+            i++;
+            continue;
+        }
+        DeleteResource(res);
+        unloaded_[i] = unloaded_.back();
+        unloaded_.pop_back();
+        freed++;
+    }
+    return freed;
+}
+
+
+size_t ResourceManager::GetResidentBytes(ResourceType type) const {
+
+    return resident_bytes_[type];
+}
+
+
+size_t ResourceManager::GetResidentBytes(void) const {
+
+    size_t bytes = 0;
+    for (int i = 0; i < NUM_RESOURCE_TYPES; i++){
+        bytes += resident_bytes_[i];
+    }
+    return bytes;
+}
+
+
+void ResourceManager::SetResourceBytes(Resource *res, size_t bytes){
+
+    resident_bytes_[res->GetType()] += bytes - res->GetBytes();
+    res->SetBytes(bytes);
+}
+
+
+void ResourceManager::DeleteResource(Resource *res){
+
+    resident_bytes_[res->GetType()] -= res->GetBytes();
+
+    // A texture still loading shows the shared placeholder, which is
+    // not its own to delete
+    if ((res->GetType() == Texture) && (res->GetResource() == placeholder_texture_)){
+        res->SetResource(0);
+    }
+
+    // Nor are the levels of a deleted texture streamed any further
+    for (unsigned int i = 0; i < streaming_.size(); ){
+        if (streaming_[i]->resource == res){
+            streaming_[i] = streaming_.back();
+            streaming_.pop_back();
+        } else {
+            i++;
+        }
+    }
+    delete res;
+}
+
+
+bool ResourceManager::FindSlot(const std::string name, ResourceType type, unsigned int &index, unsigned int &generation) const {
+
+    std::unordered_map<std::string, unsigned int>::const_iterator it = index_.find(name);
+    if (it == index_.end()){
+        return false;
+    }
+
+    // Handles only refer to resources of their own kind; point sets are
+    // geometry as well
+    ResourceType found = slot_[it->second].resource->GetType();
+    if ((found != type) && !((type == Mesh) && (found == PointSet))){
+        return false;
+    }
+
+    index = it->second;
+    generation = slot_[it->second].generation;
+    return true;
+}
+
+
+Resource *ResourceManager::ResolveSlot(unsigned int index, unsigned int generation) const {
+
+    if (index >= slot_.size()){
+        return NULL;
+    }
+    const ResourceSlot &slot = slot_[index];
+    if (slot.generation != generation){
+        return NULL;
+    }
+    return slot.resource;
+}
+
+
+void ResourceManager::LoadInstancedMaterial(const std::string name, const char *prefix){
+
+    LoadMaterial(name, prefix, INSTANCED_VERTEX_PROGRAM_EXTENSION);
+}
+
+
+void ResourceManager::LoadMaterial(const std::string name, const char *prefix, const char *vertex_extension){
+
+    BeginMaterial(name, prefix, vertex_extension);
+    FinishMaterials();
+}
+
+
+void ResourceManager::BeginMaterial(const std::string name, const char *prefix, const char *vertex_extension){
+
+    PendingProgram program;
+    program.name = name;
+
+    // Load vertex program source code
+    std::string filename = std::string(prefix) + std::string(vertex_extension);
+    program.vertex_source = LoadTextFile(filename.c_str());
+
+    // Load fragment program source code
+    filename = std::string(prefix) + std::string(FRAGMENT_PROGRAM_EXTENSION);
+    program.fragment_source = LoadTextFile(filename.c_str());
+
+    // Restore the program linked by a previous run if the sources and the
+    // driver did not change; otherwise compile it
+    program.program = glCreateProgram();
+    program.vertex_shader = program.fragment_shader = 0;
+    program.key = 0;
+    program.from_cache = false;
+    std::string path = GetProgramCachePath(name);
+    if (!path.empty() && ProgramBinarySupported()){
+        program.key = ProgramCacheKey(program.vertex_source, program.fragment_source);
+        program.from_cache = LoadProgramBinary(path, program.key, program.program);
+    }
+    if (!program.from_cache){
+        CompileProgram(program);
+    }
+
+    // Status checks wait for the driver, so they are left to
+    // FinishMaterials: compiles and links of all programs begun before
+    // then can overlap
+    linking_.push_back(program);
+}
+
+
+void ResourceManager::CompileProgram(PendingProgram &program){
+
+    // Let the driver compile on its own threads; the setting belongs to
+    // the context, so it is made again for a new one
+    GLFWwindow *context = glfwGetCurrentContext();
+    if (compiler_context_ != context){
+        if (GLEW_KHR_parallel_shader_compile){
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        }
+        compiler_context_ = context;
+    }
+
+    // Create a shader from the vertex program source code
+    program.vertex_shader = glCreateShader(GL_VERTEX_SHADER);
+    const char *source_vp = program.vertex_source.c_str();
+    glShaderSource(program.vertex_shader, 1, &source_vp, NULL);
+    glCompileShader(program.vertex_shader);
+
+    // Create a shader from the fragment program source code
+    program.fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
+    const char *source_fp = program.fragment_source.c_str();
+    glShaderSource(program.fragment_shader, 1, &source_fp, NULL);
+    glCompileShader(program.fragment_shader);
+
+    // Create a shader program linking both vertex and fragment shaders
+    // together
+    GLuint sp = program.program;
+    glAttachShader(sp, program.vertex_shader);
+    glAttachShader(sp, program.fragment_shader);
+    // Use the same attribute locations in every program
+    glBindAttribLocation(sp, VertexAttribute, "vertex");
+    glBindAttribLocation(sp, NormalAttribute, "normal");
+    glBindAttribLocation(sp, ColorAttribute, "color");
+    glBindAttribLocation(sp, UvAttribute, "uv");
+    glBindAttribLocation(sp, InstanceAttribute, "instance_mat");
+    // Keep the binary available for the program cache
+    if (program.key){
+        glProgramParameteri(sp, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(sp);
 }
 
 
-void ResourceManager::AddResource(ResourceType type, const std::string name, GLuint array_buffer, GLuint element_array_buffer, GLsizei size){
-
-    Resource *res;
+void ResourceManager::FinishMaterials(void){
 
-    res = new Resource(type, name, array_buffer, element_array_buffer, size);
+    std::vector<PendingProgram> linking;
+    linking.swap(linking_);
 
-    resource_.push_back(res);
+    // If a program fails, the ones not added as materials yet are
+    // deleted with it
+    unsigned int i = 0;
+    try {
+        for (; i < linking.size(); i++){
+            FinishProgram(linking[i]);
+        }
+    }
+    catch (...){
+        for (; i < linking.size(); i++){
+            glDeleteShader(linking[i].vertex_shader);
+            glDeleteShader(linking[i].fragment_shader);
+            glDeleteProgram(linking[i].program);
+        }
+        throw;
+    }
 }
 
 
-void ResourceManager::LoadResource(ResourceType type, const std::string name, const char *filename){
+void ResourceManager::FinishProgram(PendingProgram &program){
 
-    // Call appropriate method depending on type of resource
-    if (type == Material){
-        LoadMaterial(name, filename);
-    } else if (type == Texture){
-        LoadTexture(name, filename);
-    } else if (type == Mesh){
-        LoadMesh(name, filename);
-    } else {
-        throw(std::invalid_argument(std::string("Invalid type of resource")));
+    GLuint sp = program.program;
+    GLint status;
+
+    // A cached binary the driver rejects is compiled from source
+    if (program.from_cache){
+        glGetProgramiv(sp, GL_LINK_STATUS, &status);
+        if (status != GL_TRUE){
+            glDeleteProgram(sp);
+            program.program = sp = glCreateProgram();
+            program.from_cache = false;
+            CompileProgram(program);
+        }
     }
-}
 
+    if (!program.from_cache){
+        // Check if shaders compiled successfully
+        glGetShaderiv(program.vertex_shader, GL_COMPILE_STATUS, &status);
+        if (status != GL_TRUE){
+            char buffer[512];
+            glGetShaderInfoLog(program.vertex_shader, 512, NULL, buffer);
+            throw(std::ios_base::failure(std::string("Error compiling vertex shader: ")+std::string(buffer)));
+        }
+        glGetShaderiv(program.fragment_shader, GL_COMPILE_STATUS, &status);
+        if (status != GL_TRUE){
+            char buffer[512];
+            glGetShaderInfoLog(program.fragment_shader, 512, NULL, buffer);
+            throw(std::ios_base::failure(std::string("Error compiling fragment shader: ")+std::string(buffer)));
+        }
+
+        // Check if shaders were linked successfully
+        glGetProgramiv(sp, GL_LINK_STATUS, &status);
+        if (status != GL_TRUE){
+            char buffer[512];
+            glGetProgramInfoLog(sp, 512, NULL, buffer);
+            throw(std::ios_base::failure(std::string("Error linking shaders: ")+std::string(buffer)));
+        }
 
-Resource *ResourceManager::GetResource(const std::string name) const {
+        // Delete memory used by shaders, since they were already
+        // compiled and linked
+        glDeleteShader(program.vertex_shader);
+        glDeleteShader(program.fragment_shader);
+        program.vertex_shader = program.fragment_shader = 0;
 
-    // Find resource with the specified name
-    for (int i = 0; i < resource_.size(); i++){
-        if (resource_[i]->GetName() == name){
-            return resource_[i];
+        // Save the binary for the next run
+        if (program.key){
+            SaveProgramBinary(GetProgramCachePath(program.name), program.key, sp);
         }
     }
-    return NULL;
-}
 
+    // Uniform state is not part of the binary: set it in both cases
+    // Textures are always bound to the first texture unit
+    GLint texture_map = glGetUniformLocation(sp, "texture_map");
+    if (texture_map >= 0){
+        glUseProgram(sp);
+        glUniform1i(texture_map, 0);
+        glUseProgram(0);
+    }
 
-void ResourceManager::LoadMaterial(const std::string name, const char *prefix){
+    // Per-frame globals are read from the uniform buffer bound by the
+    // scene graph
+    GLuint globals_block = glGetUniformBlockIndex(sp, FRAME_GLOBALS_BLOCK);
+    if (globals_block != GL_INVALID_INDEX){
+        glUniformBlockBinding(sp, globals_block, FRAME_GLOBALS_BINDING);
+    }
 
-    // Load vertex program source code
-    std::string filename = std::string(prefix) + std::string(VERTEX_PROGRAM_EXTENSION);
-    std::string vp = LoadTextFile(filename.c_str());
+    // Add a resource for the shader program, with the locations of
+    // its inputs queried once here rather than on every draw
+    Resource *res = AddResource(Material, program.name, sp, 0);
+    // The material owns the program from now on
+    program.program = 0;
+    res->SetLocations(new ShaderLocations(sp));
+}
 
-    // Load fragment program source code
-    filename = std::string(prefix) + std::string(FRAGMENT_PROGRAM_EXTENSION);
-    std::string fp = LoadTextFile(filename.c_str());
 
-    // Create a shader from the vertex program source code
-    GLuint vs = glCreateShader(GL_VERTEX_SHADER);
-    const char *source_vp = vp.c_str();
-    glShaderSource(vs, 1, &source_vp, NULL);
-    glCompileShader(vs);
+std::string ResourceManager::GetProgramCachePath(const std::string name) const {
 
-    // Check if shader compiled successfully
-    GLint status;
-    glGetShaderiv(vs, GL_COMPILE_STATUS, &status);
-    if (status != GL_TRUE){
-        char buffer[512];
-        glGetShaderInfoLog(vs, 512, NULL, buffer);
-        throw(std::ios_base::failure(std::string("Error compiling vertex shader: ")+std::string(buffer)));
+    if (program_cache_directory_.empty()){
+        return std::string("");
     }
+    return program_cache_directory_ + std::string("/") + name + std::string(PROGRAM_CACHE_EXTENSION);
+}
 
-    // Create a shader from the fragment program source code
-    GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
-    const char *source_fp = fp.c_str();
-    glShaderSource(fs, 1, &source_fp, NULL);
-    glCompileShader(fs);
 
-    // Check if shader compiled successfully
-    glGetShaderiv(fs, GL_COMPILE_STATUS, &status);
-    if (status != GL_TRUE){
-        char buffer[512];
-        glGetShaderInfoLog(fs, 512, NULL, buffer);
-        throw(std::ios_base::failure(std::string("Error compiling fragment shader: ")+std::string(buffer)));
-    }
+GLuint ResourceManager::CreateVertexArray(GLuint array_buffer, GLuint element_array_buffer, const VertexFormat &format){
 
-    // Create a shader program linking both vertex and fragment shaders
-    // together
-    GLuint sp = glCreateProgram();
-    glAttachShader(sp, vs);
-    glAttachShader(sp, fs);
-    glLinkProgram(sp);
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
 
-    // Check if shaders were linked successfully
-    glGetProgramiv(sp, GL_LINK_STATUS, &status);
-    if (status != GL_TRUE){
-        char buffer[512];
-        glGetShaderInfoLog(sp, 512, NULL, buffer);
-        throw(std::ios_base::failure(std::string("Error linking shaders: ")+std::string(buffer)));
-    }
+    // The element buffer binding is part of the vertex array state
+    glBindBuffer(GL_ARRAY_BUFFER, array_buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_array_buffer);
 
-    // Delete memory used by shaders, since they were already compiled
-    // and linked
-    glDeleteShader(vs);
-    glDeleteShader(fs);
+    SetupVertexAttributes(format);
 
-    // Add a resource for the shader program
-    AddResource(Material, name, sp, 0);
+    // Unbind so later buffer bindings do not modify this vertex array
+    glBindVertexArray(0);
+
+    return vao;
 }
 
 
@@ -158,6 +973,13 @@ void ResourceManager::CreateTorus(std::string object_name, float loop_radius, fl
     // Create a torus
     // The torus is built from a large loop with small circles around the loop
 
+    // Reuse the geometry saved by a previous run
+    float parameter[] = { loop_radius, circle_radius, (float) num_loop_samples, (float) num_circle_samples };
+    uint64_t key = MeshCacheKey("torus", parameter, sizeof(parameter));
+    if (LoadCachedMesh(object_name, key)){
+        return;
+    }
+
     // Number of vertices and faces to be created
     // Check the construction algorithm below to understand the numbers
     // specified below
@@ -169,17 +991,8 @@ void ResourceManager::CreateTorus(std::string object_name, float loop_radius, fl
     const int face_att = 3;
 
     // Data buffers for the torus
-    GLfloat *vertex = NULL;
-    GLuint *face = NULL;
-
-    // Allocate memory for buffers
-    try {
-        vertex = new GLfloat[vertex_num * vertex_att]; // 11 attributes per vertex: 3D position (3), 3D normal (3), RGB color (3), 2D texture coordinates (2)
-        face = new GLuint[face_num * face_att]; // 3 indices per face
-    }
-    catch  (std::exception &e){
-        throw e;
-    }
+    std::vector<GLfloat> vertex(vertex_num * vertex_att); // 11 attributes per vertex: 3D position (3), 3D normal (3), RGB color (3), 2D texture coordinates (2)
+    std::vector<GLuint> face(face_num * face_att); // 3 indices per face
 
     // Create vertices 
     float theta, phi; // Angles for circles
@@ -236,26 +1049,8 @@ void ResourceManager::CreateTorus(std::string object_name, float loop_radius, fl
         }
     }
 
-    // Create OpenGL buffers and copy data
-    //GLuint vao;
-    //glGenVertexArrays(1, &vao);
-    //glBindVertexArray(vao);
-
-    GLuint vbo, ebo;
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertex_num * vertex_att * sizeof(GLfloat), vertex, GL_STATIC_DRAW);
-
-    glGenBuffers(1, &ebo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, face_num * face_att * sizeof(GLuint), face, GL_STATIC_DRAW);
-
-    // Free data buffers
-    delete [] vertex;
-    delete [] face;
-
-    // Create resource
-    AddResource(Mesh, object_name, vbo, ebo, face_num * face_att);
+    // Optimize, copy data to OpenGL buffers and create resource
+    UploadMesh(object_name, vertex, face, key);
 }
 
 
@@ -263,6 +1058,13 @@ void ResourceManager::CreateSphere(std::string object_name, float radius, int nu
 
     // Create a sphere using a well-known parameterization
 
+    // Reuse the geometry saved by a previous run
+    float parameter[] = { radius, (float) num_samples_theta, (float) num_samples_phi };
+    uint64_t key = MeshCacheKey("sphere", parameter, sizeof(parameter));
+    if (LoadCachedMesh(object_name, key)){
+        return;
+    }
+
     // Number of vertices and faces to be created
     const GLuint vertex_num = num_samples_theta*num_samples_phi;
     const GLuint face_num = num_samples_theta*(num_samples_phi-1)*2;
@@ -272,17 +1074,8 @@ void ResourceManager::CreateSphere(std::string object_name, float radius, int nu
     const int face_att = 3;
 
     // Data buffers 
-    GLfloat *vertex = NULL;
-    GLuint *face = NULL;
-
-    // Allocate memory for buffers
-    try {
-        vertex = new GLfloat[vertex_num * vertex_att]; // 11 attributes per vertex: 3D position (3), 3D normal (3), RGB color (3), 2D texture coordinates (2)
-        face = new GLuint[face_num * face_att]; // 3 indices per face
-    }
-    catch  (std::exception &e){
-        throw e;
-    }
+    std::vector<GLfloat> vertex(vertex_num * vertex_att); // 11 attributes per vertex: 3D position (3), 3D normal (3), RGB color (3), 2D texture coordinates (2)
+    std::vector<GLuint> face(face_num * face_att); // 3 indices per face
 
     // Create vertices 
     float theta, phi; // Angles for parametric equation
@@ -338,30 +1131,20 @@ void ResourceManager::CreateSphere(std::string object_name, float radius, int nu
         }
     }
 
-    // Create OpenGL buffers and copy data
-    //GLuint vao;
-    //glGenVertexArrays(1, &vao);
-    //glBindVertexArray(vao);
-
-    GLuint vbo, ebo;
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertex_num * vertex_att * sizeof(GLfloat), vertex, GL_STATIC_DRAW);
-
-    glGenBuffers(1, &ebo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, face_num * face_att * sizeof(GLuint), face, GL_STATIC_DRAW);
-
-    // Free data buffers
-    delete [] vertex;
-    delete [] face;
-
-    // Create resource
-    AddResource(Mesh, object_name, vbo, ebo, face_num * face_att);
+    // Optimize, copy data to OpenGL buffers and create resource
+    UploadMesh(object_name, vertex, face, key);
 }
 
 void ResourceManager::CreateCylinder(std::string object_name, glm::vec3 colour) {
 	const GLuint SIDES = 100;
+
+	// Reuse the geometry saved by a previous run
+	float parameter[] = { colour.x, colour.y, colour.z, (float) SIDES };
+	uint64_t key = MeshCacheKey("cylinder", parameter, sizeof(parameter));
+	if (LoadCachedMesh(object_name, key)){
+		return;
+	}
+
 	// The construction does not use shared vertices, since we need to assign appropriate normals to each face to create sharp edges
 	// Each face of the cube is defined by four vertices (with the same normal) and two triangles
 
@@ -484,157 +1267,276 @@ void ResourceManager::CreateCylinder(std::string object_name, glm::vec3 colour)
 	for (int i = 0; i < face_num*face_att; i++) {
 		face[i] = i;
 	}
-	// Create OpenGL vertex buffer for model
-	GLuint vbo, ebo;
-	glGenBuffers(1, &vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertex), vertex, GL_STATIC_DRAW);
-
-	glGenBuffers(1, &ebo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(face), face, GL_STATIC_DRAW);
-	AddResource(Mesh, object_name, vbo, ebo, face_num * face_att);
+	// Optimize, copy data to OpenGL buffers and create resource
+	std::vector<GLfloat> vertex_data(vertex, vertex + sizeof(vertex) / sizeof(GLfloat));
+	std::vector<GLuint> face_data(face, face + face_num * face_att);
+	UploadMesh(object_name, vertex_data, face_data, key);
 }
 
 void ResourceManager::LoadTexture(const std::string name, const char *filename){
 
-    // Load texture from file
-    GLuint texture = SOIL_load_OGL_texture(filename, SOIL_LOAD_AUTO, SOIL_CREATE_NEW_ID, 0);
-    if (!texture){
+    // Prefer the texture container, with its mipmaps built offline
+    std::shared_ptr<StreamedTexture> stream(new StreamedTexture);
+    if (ReadTextureStream(filename, *stream)){
+        StartTextureStream(AddResource(Texture, name, 0, 0), stream);
+        return;
+    }
+
+    // Load image from file
+    int width, height, channels;
+    unsigned char *image = SOIL_load_image(filename, &width, &height, &channels, SOIL_LOAD_RGBA);
+    if (!image){
         throw(std::ios_base::failure(std::string("Error loading texture ")+std::string(filename)+std::string(": ")+std::string(SOIL_last_result())));
     }
 
+    GLuint texture = CreateTexture(image, width, height);
+    SOIL_free_image_data(image);
+
     // Create resource
-    AddResource(Texture, name, texture, 0);
+    Resource *res = AddResource(Texture, name, texture, 0);
+    SetResourceBytes(res, TextureBytes(width, height));
 }
 
 
-void ResourceManager::LoadMesh(const std::string name, const char *filename){
+GLuint ResourceManager::CreateTexture(const unsigned char *image, int width, int height){
 
-    // First load model into memory. If that goes well, we transfer the
-    // mesh to an OpenGL buffer
-    TriMesh mesh;
+    // Create texture with its full mipmap chain
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    int levels = 1 + (int) floor(log2((double) std::max(width, height)));
+    if (GLEW_ARB_texture_storage){
+        // Immutable storage: size and format can no longer change, which
+        // lets the driver skip completeness checks when binding
+        glTexStorage2D(GL_TEXTURE_2D, levels, GL_RGBA8, width, height);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, image);
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
+    }
 
-    // Parse file
-    // Open file
-    std::ifstream f;
-    f.open(filename);
-    if (f.fail()){
-        throw(std::ios_base::failure(std::string("Error opening file ")+std::string(filename)));
+    // Build mipmaps once, here, instead of on every draw
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    // Define texture interpolation
+    SetupSampler(texture);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return texture;
+}
+
+
+bool ResourceManager::ReadTextureStream(const std::string filename, StreamedTexture &texture) const {
+
+    if (!ReadTextureContainer(GetTextureContainerPath(filename), texture.container)){
+        return false;
+    }
+    texture.format = texture.container.format;
+    texture.resource = NULL;
+    texture.level = texture.container.level.size();
+
+    // Without S3TC, upload the blocks as the pixels they encode; still
+    // cheaper than decoding the image and building the mipmaps
+    if ((texture.format != TextureRGBA8) && !GLEW_EXT_texture_compression_s3tc){
+        texture.decoded.resize(texture.container.level.size());
+        for (unsigned int i = 0; i < texture.container.level.size(); i++){
+            const TextureLevel &level = texture.container.level[i];
+            DecompressTexture(texture.format, GetTextureLevelData(texture.container, i), level.width, level.height, texture.decoded[i]);
+        }
+        texture.format = TextureRGBA8;
     }
+    return true;
+}
 
-    // Parse lines
-    std::string line;
-    std::string ignore(" \t\r\n");
-    std::string part_separator(" \t");
-    std::string face_separator("/");
-    bool added_normal = false;
-    while (std::getline(f, line)){
-        // Clean extremities of the string
-        string_trim(line, ignore);
-        // Ignore comments
-        if ((line.size() <= 0) ||
-            (line[0] == '#')){
-            continue;
+
+void ResourceManager::StartTextureStream(Resource *res, std::shared_ptr<StreamedTexture> texture){
+
+    const std::vector<TextureLevel> &level = texture->container.level;
+    int level_num = level.size();
+    texture->resource = res;
+
+    // Storage for the whole chain, in the format of the container
+    GLuint id;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    if (GLEW_ARB_texture_storage){
+        glTexStorage2D(GL_TEXTURE_2D, level_num, TextureInternalFormat(texture->format), level[0].width, level[0].height);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level_num - 1);
+    SetupSampler(id);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    res->SetResource(id);
+
+    size_t bytes = 0;
+    for (int i = 0; i < level_num; i++){
+        bytes += TextureLevelSize(texture->format, level[i].width, level[i].height);
+    }
+    SetResourceBytes(res, bytes);
+
+    // The coarse levels are enough to draw with: the texture is usable
+    // now and sharpens as the finer levels arrive
+    for (int i = level_num - 1; i >= 0; i--){
+        if ((i < level_num - 1) && (std::max(level[i].width, level[i].height) > TEXTURE_STREAM_FIRST_SIZE)){
+            break;
         }
-        // Parse string
-        std::vector<std::string> part = string_split(line, part_separator);
-        // Check commands
-        if (!part[0].compare(std::string("v"))){
-            if (part.size() >= 4){
-                glm::vec3 position(str_to_num<float>(part[1].c_str()), str_to_num<float>(part[2].c_str()), str_to_num<float>(part[3].c_str()));
-                mesh.position.push_back(position);
-            } else {
-                throw(std::ios_base::failure(std::string("Error: v command should have exactly 3 parameters")));
-            }
-        } else if (!part[0].compare(std::string("vn"))){
-            if (part.size() >= 4){
-                glm::vec3 normal(str_to_num<float>(part[1].c_str()), str_to_num<float>(part[2].c_str()), str_to_num<float>(part[3].c_str()));
-                mesh.normal.push_back(normal);
-                added_normal = true;
-            } else {
-                throw(std::ios_base::failure(std::string("Error: vn command should have exactly 3 parameters")));
-            }
-        } else if (!part[0].compare(std::string("vt"))){
-            if (part.size() >= 3){
-                glm::vec2 tex_coord(str_to_num<float>(part[1].c_str()), str_to_num<float>(part[2].c_str()));
-                mesh.tex_coord.push_back(tex_coord);
-            } else {
-                throw(std::ios_base::failure(std::string("Error: vt command should have exactly 2 parameters")));
-            }
-        } else if (!part[0].compare(std::string("f"))){
-            if (part.size() >= 4){
-                if (part.size() > 5){
-                    throw(std::ios_base::failure(std::string("Error: f commands with more than 4 vertices not supported")));
-                } else if (part.size() == 5){
-                    // Break a quad into two triangles
-                    Quad quad;
-                    for (int i = 0; i < 4; i++){
-                        std::vector<std::string> fd = string_split_once(part[i+1], face_separator);
-                        if (fd.size() == 1){
-                            quad.i[i] = str_to_num<float>(fd[0].c_str())-1;
-                            quad.t[i] = -1;
-                            quad.n[i] = -1;
-                        } else if (fd.size() == 2){
-                            quad.i[i] = str_to_num<float>(fd[0].c_str())-1;
-                            quad.t[i] = str_to_num<float>(fd[1].c_str())-1;
-                            quad.n[i] = -1;
-                        } else if (fd.size() == 3){
-                            quad.i[i] = str_to_num<float>(fd[0].c_str())-1;
-                            if (std::string("").compare(fd[1]) != 0){
-                                quad.t[i] = str_to_num<float>(fd[1].c_str())-1;
-                            } else {
-                                quad.t[i] = -1;
-                            }
-                            quad.n[i] = str_to_num<float>(fd[2].c_str())-1;
-                        } else {
-                            throw(std::ios_base::failure(std::string("Error: f parameter should have 1 or 3 parameters separated by '/'")));
-                        }
-                    }
-                    Face face1, face2;
-                    face1.i[0] = quad.i[0]; face1.i[1] = quad.i[1]; face1.i[2] = quad.i[2];
-                    face1.n[0] = quad.n[0]; face1.n[1] = quad.n[1]; face1.n[2] = quad.n[2];
-                    face1.t[0] = quad.t[0]; face1.t[1] = quad.t[1]; face1.t[2] = quad.t[2];
-                    face2.i[0] = quad.i[0]; face2.i[1] = quad.i[2]; face2.i[2] = quad.i[3];
-                    face2.n[0] = quad.n[0]; face2.n[1] = quad.n[2]; face2.n[2] = quad.n[3];
-                    face2.t[0] = quad.t[0]; face2.t[1] = quad.t[2]; face2.t[2] = quad.t[3];
-                    mesh.face.push_back(face1);
-                    mesh.face.push_back(face2);
-                } else if (part.size() == 4){
-                    Face face;
-                    for (int i = 0; i < 3; i++){
-                        std::vector<std::string> fd = string_split_once(part[i+1], face_separator);
-                        if (fd.size() == 1){
-                            face.i[i] = str_to_num<float>(fd[0].c_str())-1;
-                            face.t[i] = -1;
-                            face.n[i] = -1;
-                        } else if (fd.size() == 2){
-                            face.i[i] = str_to_num<float>(fd[0].c_str())-1;
-                            face.t[i] = str_to_num<float>(fd[1].c_str())-1;
-                            face.n[i] = -1;
-                        } else if (fd.size() == 3){
-                            face.i[i] = str_to_num<float>(fd[0].c_str())-1;
-                            if (std::string("").compare(fd[1]) != 0){
-                                face.t[i] = str_to_num<float>(fd[1].c_str())-1;
-                            } else {
-                                face.t[i] = -1;
-                            }
-                            face.n[i] = str_to_num<float>(fd[2].c_str())-1;
-                        } else {
-                            throw(std::ios_base::failure(std::string("Error: f parameter should have 1, 2, or 3 parameters separated by '/'")));
-                        }
-                    }
-                    mesh.face.push_back(face);
-                }
-            } else {
-                throw(std::ios_base::failure(std::string("Error: f command should have 3 or 4 parameters")));
+        UploadTextureLevel(*texture, i);
+    }
+    res->SetReady(true);
+    if (texture->level > 0){
+        streaming_.push_back(texture);
+    }
+}
+
+
+int ResourceManager::StreamTextures(double time_budget){
+
+    // One level per texture and frame, at least one level in all
+    double start = glfwGetTime();
+    int count = 0;
+    for (unsigned int i = 0; i < streaming_.size(); ){
+        if ((count > 0) && ((glfwGetTime() - start) >= time_budget)){
+            break;
+        }
+        StreamedTexture &texture = *streaming_[i];
+        UploadTextureLevel(texture, texture.level - 1);
+        count++;
+        if (texture.level == 0){
+            // Done: the mapping and decoded levels are released here
+            streaming_[i] = streaming_.back();
+            streaming_.pop_back();
+        } else {
+            i++;
+        }
+    }
+    return count;
+}
+
+
+void ResourceManager::UploadTextureLevel(StreamedTexture &texture, int level){
+
+    const TextureLevel &desc = texture.container.level[level];
+    const unsigned char *data = texture.decoded.empty() ? GetTextureLevelData(texture.container, level) : &texture.decoded[level][0];
+    GLsizei size = TextureLevelSize(texture.format, desc.width, desc.height);
+    GLenum internal_format = TextureInternalFormat(texture.format);
+
+    glBindTexture(GL_TEXTURE_2D, texture.resource->GetResource());
+    if (GLEW_ARB_texture_storage){
+        if (texture.format == TextureRGBA8){
+            glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, desc.width, desc.height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        } else {
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, desc.width, desc.height, internal_format, size, data);
+        }
+    } else {
+        if (texture.format == TextureRGBA8){
+            glTexImage2D(GL_TEXTURE_2D, level, internal_format, desc.width, desc.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        } else {
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, internal_format, desc.width, desc.height, 0, size, data);
+        }
+    }
+    // Sampling starts at the finest level uploaded, so the texture is
+    // complete at every step
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    texture.level = level;
+}
+
+
+GLuint ResourceManager::GetPlaceholderTexture(void){
+
+    // A single white texel, so lit materials look plain until the
+    // actual texture arrives
+    if (!placeholder_texture_){
+        const unsigned char white[4] = { 255, 255, 255, 255 };
+        glGenTextures(1, &placeholder_texture_);
+        glBindTexture(GL_TEXTURE_2D, placeholder_texture_);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+        // No mipmaps: the single level is complete with any filtering
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        SetupSampler(placeholder_texture_);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    return placeholder_texture_;
+}
+
+
+void ResourceManager::SetupSampler(GLuint texture){
+
+    // Maximum anisotropy supported, if any
+    GLfloat anisotropy = 0.0;
+    if (GLEW_EXT_texture_filter_anisotropic){
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &anisotropy);
+    }
+
+    if (GLEW_ARB_sampler_objects){
+        // One sampler for all textures, bound once to the texture unit
+        if (!sampler_){
+            glGenSamplers(1, &sampler_);
+            glSamplerParameteri(sampler_, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+            glSamplerParameteri(sampler_, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            if (anisotropy > 0.0){
+                glSamplerParameterf(sampler_, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy);
             }
+            glBindSampler(0, sampler_);
+        }
+    } else {
+        // Without sampler objects, store filtering in the texture itself
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        if (anisotropy > 0.0){
+            glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy);
         }
-        // Ignore other commands
     }
+}
 
-    // Close file
-    f.close();
+
+// Indices of the position, texture coordinates and normal of one vertex
+// of an obj face, used to merge identical vertices
+struct VertexKey {
+    int i, t, n;
+    bool operator==(const VertexKey &other) const {
+        return (i == other.i) && (t == other.t) && (n == other.n);
+    }
+};
+
+struct VertexKeyHash {
+    size_t operator()(const VertexKey &key) const {
+        size_t h = (size_t) key.i * 73856093u;
+        h ^= (size_t) (key.t + 1) * 19349663u;
+        h ^= (size_t) (key.n + 1) * 83492791u;
+        return h;
+    }
+};
+
+
+void ResourceManager::LoadMesh(const std::string name, const char *filename){
+
+    // Use the cache built by a previous run if the file did not change
+    // since then
+    uint64_t stamp = HashFileStamp(filename, 0);
+    uint64_t key = MeshCacheKey(filename, &stamp, sizeof(stamp));
+    if (stamp && LoadCachedMesh(name, key)){
+        return;
+    }
+
+    std::vector<GLfloat> vertex;
+    std::vector<GLuint> face;
+    ReadMesh(filename, vertex, face);
+
+    // Optimize, copy data to OpenGL buffers and create resource
+    UploadMesh(name, vertex, face, stamp ? key : 0);
+}
+
+
+void ResourceManager::ReadMesh(const char *filename, std::vector<GLfloat> &vertex, std::vector<GLuint> &face) const {
+
+    // First load model into memory. If that goes well, we build the
+    // arrays for the OpenGL buffers
+    TriMesh mesh;
+
+    // Parse file with a single read; the mesh vectors are reserved
+    // up front and polygons are split into triangles
+    load_obj(filename, mesh);
+    bool added_normal = !mesh.normal.empty();
 
     // Check if vertex references are correct
     for (unsigned int i = 0; i < mesh.face.size(); i++){
@@ -642,6 +1544,10 @@ void ResourceManager::LoadMesh(const std::string name, const char *filename){
             if (mesh.face[i].i[j] >= mesh.position.size()){
                 throw(std::ios_base::failure(std::string("Error: index for triangle ")+num_to_str<int>(mesh.face[i].i[j])+std::string(" is out of bounds")));
             }
+            if ((mesh.face[i].n[j] >= (int) mesh.normal.size()) ||
+                (mesh.face[i].t[j] >= (int) mesh.tex_coord.size())){
+                throw(std::ios_base::failure(std::string("Error: normal or texture coordinate index of triangle ")+num_to_str<int>(i)+std::string(" is out of bounds")));
+            }
         }
     }
 
@@ -682,73 +1588,194 @@ void ResourceManager::LoadMesh(const std::string name, const char *filename){
 
     // If we got to this point, the file was parsed successfully and the
     // mesh is in memory
-    // Now, transfer the mesh to OpenGL buffers
-    // Create three new vertices for each face, in case vertex
-    // normals/texture coordinates are not consistent over the mesh
+    // Now, build the vertex and index arrays: faces refer to positions,
+    // normals and texture coordinates separately, so every distinct
+    // (position, texture coordinate, normal) triple becomes one vertex
+    // shared by all faces that use it
 
     // Number of attributes for vertices and faces
     const int vertex_att = 11;
     const int face_att = 3;
 
-    // Create OpenGL buffers and copy data
-    GLuint vbo, ebo;
-
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, mesh.face.size() * 3 * vertex_att * sizeof(GLuint), 0, GL_STATIC_DRAW);
+    vertex.clear();
+    face.clear();
+    vertex.reserve(mesh.position.size() * vertex_att);
+    face.reserve(mesh.face.size() * face_att);
 
-    glGenBuffers(1, &ebo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.face.size() * face_att * sizeof(GLuint), 0, GL_STATIC_DRAW);
-
-    unsigned int vertex_index = 0;
+    std::unordered_map<VertexKey, GLuint, VertexKeyHash> vertex_index;
+    vertex_index.reserve(mesh.position.size() * 2);
     for (unsigned int i = 0; i < mesh.face.size(); i++){
-        // Add three vertices and their attributes
-        GLfloat att[3 * vertex_att] = { 0 };
         for (int j = 0; j < 3; j++){
-            // Position
-            att[j*vertex_att + 0] = mesh.position[mesh.face[i].i[j]][0];
-            att[j*vertex_att + 1] = mesh.position[mesh.face[i].i[j]][1];
-            att[j*vertex_att + 2] = mesh.position[mesh.face[i].i[j]][2];
-            // Normal
-            if (!added_normal){
-                att[j*vertex_att + 3] = mesh.normal[mesh.face[i].i[j]][0];
-                att[j*vertex_att + 4] = mesh.normal[mesh.face[i].i[j]][1];
-                att[j*vertex_att + 5] = mesh.normal[mesh.face[i].i[j]][2];
-            } else {
-                if (mesh.face[i].n[j] >= 0){
-                    att[j*vertex_att + 3] = mesh.normal[mesh.face[i].n[j]][0];
-                    att[j*vertex_att + 4] = mesh.normal[mesh.face[i].n[j]][1];
-                    att[j*vertex_att + 5] = mesh.normal[mesh.face[i].n[j]][2];
+            // Computed normals are stored per position
+            VertexKey key;
+            key.i = mesh.face[i].i[j];
+            key.t = mesh.face[i].t[j];
+            key.n = added_normal ? mesh.face[i].n[j] : key.i;
+
+            std::pair<std::unordered_map<VertexKey, GLuint, VertexKeyHash>::iterator, bool> found =
+                vertex_index.insert(std::make_pair(key, (GLuint) (vertex.size() / vertex_att)));
+            if (found.second){
+                // New vertex: add its attributes
+                GLfloat att[vertex_att] = { 0 };
+                // Position
+                att[0] = mesh.position[key.i][0];
+                att[1] = mesh.position[key.i][1];
+                att[2] = mesh.position[key.i][2];
+                // Normal
+                if (key.n >= 0){
+                    att[3] = mesh.normal[key.n][0];
+                    att[4] = mesh.normal[key.n][1];
+                    att[5] = mesh.normal[key.n][2];
                 }
+                // No color in (6, 7, 8)
+                // Texture coordinates
+                if (key.t >= 0){
+                    att[9] = mesh.tex_coord[key.t][0];
+                    att[10] = mesh.tex_coord[key.t][1];
+                }
+                vertex.insert(vertex.end(), att, att + vertex_att);
             }
-            // No color in (6, 7, 8)
-            // Texture coordinates
-            if (mesh.face[i].t[j] >= 0){
-                att[j*vertex_att + 9] = mesh.tex_coord[mesh.face[i].t[j]][0];
-                att[j*vertex_att + 10] = mesh.tex_coord[mesh.face[i].t[j]][1];
-            }
+            face.push_back(found.first->second);
         }
+    }
+}
+
 
-        // Copy attributes to buffer
-        glBufferSubData(GL_ARRAY_BUFFER, i * 3 * vertex_att * sizeof(GLfloat), 3 * vertex_att * sizeof(GLfloat), att);
+uint64_t ResourceManager::MeshCacheKey(const char *source, const void *parameter, size_t size) const {
+
+    // Settings that change the processed mesh are part of the key
+    uint64_t key = HashBytes(source, strlen(source));
+    key = HashBytes(parameter, size, key);
+    key = HashBytes(&optimize_overdraw_, sizeof(optimize_overdraw_), key);
+    GLenum normal_type = PackedVertexFormat(false).attribute[NormalAttribute].type;
+    return HashBytes(&normal_type, sizeof(normal_type), key);
+}
 
-        // Add triangle
-        GLuint findex[face_att] = { 0 };
-        findex[0] = vertex_index;
-        findex[1] = vertex_index + 1;
-        findex[2] = vertex_index + 2;
-        vertex_index += 3;
 
-        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, i * face_att * sizeof(GLuint), face_att * sizeof(GLuint), findex);
+std::string ResourceManager::GetMeshCachePath(const std::string name) const {
+
+    if (mesh_cache_directory_.empty()){
+        return std::string("");
     }
+    return mesh_cache_directory_ + std::string("/") + name + std::string(MESH_CACHE_EXTENSION);
+}
 
-    // Create resource
-    AddResource(Mesh, name, vbo, ebo, mesh.face.size() * face_att);
+
+bool ResourceManager::LoadCachedMesh(const std::string name, uint64_t key){
+
+    std::string path = GetMeshCachePath(name);
+    if (path.empty()){
+        return false;
+    }
+
+    // The buffers are filled straight from the mapped file
+    CachedMesh cached;
+    if (!ReadMeshCache(path, key, cached)){
+        return false;
+    }
+    CreateMesh(name, cached.format, cached.bounds, cached.vertex, cached.vertex_size, cached.face, cached.index_num);
+    return true;
+}
+
+
+Resource *ResourceManager::CreateMesh(const std::string name, const VertexFormat &format, const Bounds &bounds, const void *vertex, size_t vertex_size, const GLuint *face, size_t index_num){
+
+    GLuint vbo, ebo;
+    CreateMeshBuffers(vertex, vertex_size, face, index_num, vbo, ebo);
+
+    Resource *res = AddResource(Mesh, name, vbo, ebo, format, index_num);
+    res->SetBounds(bounds);
+    SetResourceBytes(res, vertex_size + index_num * sizeof(GLuint));
+    return res;
+}
+
+
+void ResourceManager::FillMesh(Resource *res, const VertexFormat &format, const Bounds &bounds, const void *vertex, size_t vertex_size, const GLuint *face, size_t index_num){
+
+    GLuint vbo, ebo;
+    CreateMeshBuffers(vertex, vertex_size, face, index_num, vbo, ebo);
+
+    res->SetGeometry(vbo, ebo, CreateVertexArray(vbo, ebo, format), format, index_num);
+    res->SetBounds(bounds);
+    SetResourceBytes(res, vertex_size + index_num * sizeof(GLuint));
+    res->SetReady(true);
+}
+
+
+void ResourceManager::CreateMeshBuffers(const void *vertex, size_t vertex_size, const GLuint *face, size_t index_num, GLuint &array_buffer, GLuint &element_array_buffer){
+
+    // Each buffer is filled with a single call
+    glGenBuffers(1, &array_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, array_buffer);
+    glBufferData(GL_ARRAY_BUFFER, vertex_size, vertex, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &element_array_buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_array_buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_num * sizeof(GLuint), face, GL_STATIC_DRAW);
+}
+
+
+Resource *ResourceManager::UploadMesh(const std::string name, std::vector<GLfloat> &vertex, std::vector<GLuint> &face, uint64_t cache_key){
+
+    PackedMesh mesh;
+    ProcessMesh(name, vertex, face, cache_key, mesh);
+    ReportMesh(name, mesh);
+
+    return CreateMesh(name, mesh.format, mesh.bounds, mesh.vertex.empty() ? NULL : &mesh.vertex[0], mesh.vertex.size(), mesh.face.empty() ? NULL : &mesh.face[0], mesh.face.size());
+}
+
+
+void ResourceManager::ProcessMesh(const std::string name, std::vector<GLfloat> &vertex, std::vector<GLuint> &face, uint64_t cache_key, PackedMesh &mesh) const {
+
+    const int vertex_att = VERTEX_ATTRIBUTES;
+
+    // Reorder triangles for the post-transform cache, optionally group
+    // them against overdraw, then lay vertices out in order of use
+    int vertex_num = vertex.size() / vertex_att;
+    mesh.stats.triangle_num = face.size() / 3;
+    mesh.stats.acmr_before = ComputeAcmr(face, vertex_num);
+    OptimizeVertexCache(face, vertex_num);
+    if (optimize_overdraw_){
+        OptimizeOverdraw(face, vertex, vertex_att);
+    }
+    OptimizeVertexFetch(vertex, face, vertex_att);
+    mesh.stats.acmr_after = ComputeAcmr(face, vertex.size() / vertex_att);
+
+    // Pack the vertices; the color stream is kept only if some vertex
+    // has a color
+    bool color = false;
+    for (unsigned int i = 0; (i < vertex.size()) && !color; i += vertex_att){
+        color = (vertex[i + 6] != 0.0) || (vertex[i + 7] != 0.0) || (vertex[i + 8] != 0.0);
+    }
+    mesh.format = PackedVertexFormat(color);
+    PackVertices(vertex, mesh.format, mesh.vertex);
+
+    mesh.bounds = ComputeBounds(vertex.empty() ? NULL : &vertex[0], vertex.size() / vertex_att, vertex_att);
+    mesh.face.swap(face);
+
+    // Save the final buffers for the next run
+    if (cache_key && !mesh_cache_directory_.empty()){
+        WriteMeshCache(GetMeshCachePath(name), cache_key, mesh.format, mesh.bounds, mesh.vertex, mesh.face);
+    }
+}
+
+
+void ResourceManager::ReportMesh(const std::string name, const PackedMesh &mesh) const {
+
+    if (verbose_){
+        std::cout << "Mesh " << name << ": " << mesh.stats.triangle_num << " triangles, ACMR " << mesh.stats.acmr_before << " -> " << mesh.stats.acmr_after << std::endl;
+    }
 }
 
 void ResourceManager::CreatePlane(std::string object_name, glm::vec3 colour) {
 
+	// Reuse the geometry saved by a previous run
+	float parameter[] = { colour.x, colour.y, colour.z };
+	uint64_t key = MeshCacheKey("plane", parameter, sizeof(parameter));
+	if (LoadCachedMesh(object_name, key)){
+		return;
+	}
+
 	// The construction uses shared vertices 
 
 	// Vertices that form the plane
@@ -778,91 +1805,10 @@ void ResourceManager::CreatePlane(std::string object_name, glm::vec3 colour) {
 		4, 7, 8,
 	};
 
-	GLuint vbo, ebo;
-	// Create OpenGL buffer for vertices
-	glGenBuffers(1, &vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertex), vertex, GL_STATIC_DRAW);
-
-	// Create OpenGL buffer for faces
-	glGenBuffers(1, &ebo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(face), face, GL_STATIC_DRAW);
-	AddResource(Mesh, object_name, vbo, ebo, 24);
-}
-
-
-void string_trim(std::string str, std::string to_trim){
-
-    // Trim any character in to_trim from the beginning of the string str
-    while ((str.size() > 0) && 
-           (to_trim.find(str[0]) != std::string::npos)){
-        str.erase(0);
-    }
-
-    // Trim any character in to_trim from the end of the string str
-    while ((str.size() > 0) && 
-           (to_trim.find(str[str.size()-1]) != std::string::npos)){
-        str.erase(str.size()-1);
-    }
-}
-
-
-std::vector<std::string> string_split(std::string str, std::string separator){
-
-    // Initialize output
-    std::vector<std::string> output;
-    output.push_back(std::string(""));
-    int string_index = 0;
-
-    // Analyze string
-    unsigned int i = 0;
-    while (i < str.size()){
-        // Check if character i is a separator
-        if (separator.find(str[i]) != std::string::npos){
-            // Split string
-            string_index++;
-            output.push_back(std::string(""));
-            // Skip separators
-            while ((i < str.size()) && (separator.find(str[i]) != std::string::npos)){
-                i++;
-            }
-        } else {
-            // Otherwise, copy string
-            output[string_index] += str[i];
-            i++;
-        }
-    }
-
-    return output;
-}
-
-
-std::vector<std::string> string_split_once(std::string str, std::string separator){
-
-    // Initialize output
-    std::vector<std::string> output;
-    output.push_back(std::string(""));
-    int string_index = 0;
-
-    // Analyze string
-    unsigned int i = 0;
-    while (i < str.size()){
-        // Check if character i is a separator
-        if (separator.find(str[i]) != std::string::npos){
-            // Split string
-            string_index++;
-            output.push_back(std::string(""));
-            // Skip single separator
-            i++;
-        } else {
-            // Otherwise, copy string
-            output[string_index] += str[i];
-            i++;
-        }
-    }
-
-    return output;
+	// Optimize, copy data to OpenGL buffers and create resource
+	std::vector<GLfloat> vertex_data(vertex, vertex + sizeof(vertex) / sizeof(GLfloat));
+	std::vector<GLuint> face_data(face, face + sizeof(face) / sizeof(GLuint));
+	UploadMesh(object_name, vertex_data, face_data, key);
 }
 
 
@@ -902,18 +1848,4 @@ template <typename T> std::string num_to_str(T num){
 }
 
 
-template <typename T> T str_to_num(const std::string &str){
-
-    std::istringstream ss(str);
-    T result;
-    ss >> result;
-    if (ss.fail()){
-        throw(std::ios_base::failure(std::string("Invalid number: ")+str));
-    }
-    return result;
-}
-
-
-
-
 } // namespace game;
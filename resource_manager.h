@@ -3,18 +3,69 @@
 
 #include <string>
 #include <vector>
+#include <unordered_map>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <memory>
+#include <cstdint>
 #define GLEW_STATIC
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
 #include "resource.h"
+#include "handle.h"
+#include "thread_pool.h"
+#include "resource_manifest.h"
+#include "texture_container.h"
 
 // Default extensions for different shader source files
 #define VERTEX_PROGRAM_EXTENSION "_vp.glsl"
 #define FRAGMENT_PROGRAM_EXTENSION "_fp.glsl"
+// Vertex program of the instanced variant of a material
+#define INSTANCED_VERTEX_PROGRAM_EXTENSION "_instanced_vp.glsl"
+// Mipmap levels of texture containers up to this size are uploaded at
+// once; finer levels follow one per frame
+#define TEXTURE_STREAM_FIRST_SIZE 64
 
 namespace game {
 
+    // Effect of the mesh optimizer on a mesh: average number of vertices
+    // transformed per triangle, before and after
+    struct MeshStats {
+        int triangle_num;
+        float acmr_before;
+        float acmr_after;
+    };
+
+    // A mesh processed for upload: packed vertices, triangle indices and
+    // extent
+    struct PackedMesh {
+        VertexFormat format;
+        Bounds bounds;
+        std::vector<unsigned char> vertex;
+        std::vector<GLuint> face;
+        MeshStats stats;
+    };
+
+    // A texture container whose levels are being uploaded, coarsest
+    // first. Compressed levels the driver cannot sample are decompressed
+    // to RGBA8 on the worker that reads the container
+    struct StreamedTexture {
+        TextureContainer container;
+        TextureFormat format; // Format of the uploaded levels
+        std::vector<std::vector<unsigned char> > decoded;
+        Resource *resource;
+        int level; // Finest level uploaded so far
+    };
+
+    // Tags that give each kind of resource its own handle type, so a
+    // texture handle cannot be passed where a mesh is expected
+    template <ResourceType type> struct ResourceKind {};
+    typedef Handle<ResourceKind<Mesh> > MeshHandle;
+    typedef Handle<ResourceKind<Material> > MaterialHandle;
+    typedef Handle<ResourceKind<Texture> > TextureHandle;
+
     // Class that manages all resources
     class ResourceManager {
 
@@ -23,12 +74,75 @@ namespace game {
             ResourceManager(void);
             ~ResourceManager();
             // Add a resource that was already loaded and allocated to memory
-            void AddResource(ResourceType type, const std::string name, GLuint resource, GLsizei size);
-            void AddResource(ResourceType type, const std::string name, GLuint array_buffer, GLuint element_array_buffer, GLsizei size);
+            Resource *AddResource(ResourceType type, const std::string name, GLuint resource, GLsizei size);
+            Resource *AddResource(ResourceType type, const std::string name, GLuint array_buffer, GLuint element_array_buffer, const VertexFormat &format, GLsizei size);
             // Load a resource from a file, according to the specified type
             void LoadResource(ResourceType type, const std::string name, const char *filename);
+            // Load the instanced variant of a material: the instanced vertex
+            // program with the regular fragment program
+            void LoadInstancedMaterial(const std::string name, const char *prefix);
+            // Load a texture or mesh in the background and return at once
+            // The resource holds a placeholder (a white texel, or a mesh
+            // with nothing to draw) until ProcessUploads() puts the data
+            // in place; materials are loaded before returning
+            // Settings such as the mesh cache must not change while loads
+            // are pending
+            Resource *LoadResourceAsync(ResourceType type, const std::string name, const char *filename);
+            // Create the OpenGL objects of background loads that finished,
+            // on the thread that owns the context; stops once 'time_budget'
+            // seconds are used, after at least one upload. Returns the
+            // number of uploads done
+            int ProcessUploads(double time_budget);
+            // Number of background loads not uploaded yet, including
+            // manifest items waiting for their dependencies and textures
+            // still streaming their finer levels
+            int GetPendingLoads(void) const;
+            // Load the resources listed in a manifest (see
+            // resource_manifest.h). Items start once the items they depend
+            // on are ready, so independent files load in parallel on the
+            // workers; lazy items are loaded by the first lookup of their
+            // name
+            void LoadManifest(const char *filename);
             // Get the resource with the specified name
-            Resource *GetResource(const std::string name) const;
+            Resource *GetResource(const std::string name);
+            // Handles that can be kept instead of looking resources up by
+            // name; empty if no resource of that kind has the name
+            MeshHandle GetMeshHandle(const std::string name);
+            MaterialHandle GetMaterialHandle(const std::string name);
+            TextureHandle GetTextureHandle(const std::string name);
+            // Resolve a handle, or NULL if the resource is gone
+            Resource *GetResource(MeshHandle handle) const;
+            Resource *GetResource(MaterialHandle handle) const;
+            Resource *GetResource(TextureHandle handle) const;
+            // Remove a resource from the manager: its name and handles stop
+            // resolving, and its OpenGL objects are deleted once no scene
+            // node uses it (see Purge)
+            void Unload(const std::string name);
+            void Unload(MeshHandle handle);
+            void Unload(MaterialHandle handle);
+            void Unload(TextureHandle handle);
+            // Delete the unloaded resources that are no longer used;
+            // returns how many were freed
+            int Purge(void);
+            // Estimated memory of the OpenGL objects of the resources of
+            // one type, or of all resources, including unloaded ones still
+            // in use
+            size_t GetResidentBytes(ResourceType type) const;
+            size_t GetResidentBytes(void) const;
+            // Enable or disable the overdraw pass of the mesh optimizer for
+            // meshes created afterwards
+            void SetOverdrawOptimization(bool enable);
+            // Print the optimizer statistics of the meshes processed
+            // afterwards; off by default
+            void SetVerbose(bool verbose);
+            // Directory where generated and loaded meshes are saved in
+            // binary form, to be mapped directly on later runs; caching is
+            // disabled while it is empty
+            void SetMeshCacheDirectory(const std::string directory);
+            // Directory where linked shader programs are saved, to be
+            // restored with glProgramBinary on later runs with the same
+            // sources and driver; caching is disabled while it is empty
+            void SetProgramCacheDirectory(const std::string directory);
 
             // Methods to create specific resources
             // Create the geometry for a torus and add it to the list of resources
@@ -41,18 +155,162 @@ namespace game {
 			void CreatePlane(std::string object_name, glm::vec3 colour);
 
         private:
-            // List storing all resources
-            std::vector<Resource*> resource_; 
+            // Slot of each resource; the generation is bumped when the
+            // slot is reused so old handles stop resolving
+            struct ResourceSlot {
+                Resource *resource;
+                unsigned int generation;
+            };
+            std::vector<ResourceSlot> slot_;
+            // Index from resource name to slot
+            std::unordered_map<std::string, unsigned int> index_;
+            // Slots free for new resources
+            std::vector<unsigned int> free_slot_;
+            // Unloaded resources waiting for their users to go away
+            std::vector<Resource *> unloaded_;
+            // Memory of the resources of each type
+            size_t resident_bytes_[NUM_RESOURCE_TYPES];
+            // Filtering state shared by all textures, created with the
+            // first texture
+            GLuint sampler_;
+            // Whether meshes are also reordered to reduce overdraw
+            bool optimize_overdraw_;
+            // Whether mesh statistics are printed
+            bool verbose_;
+            // Directory of the mesh cache files
+            std::string mesh_cache_directory_;
+            // Directory of the program cache files
+            std::string program_cache_directory_;
+            // A shader program whose compile and link were started, but
+            // not checked yet
+            struct PendingProgram {
+                std::string name;
+                std::string vertex_source;
+                std::string fragment_source;
+                GLuint program;
+                GLuint vertex_shader;
+                GLuint fragment_shader;
+                uint64_t key; // Program cache key, 0 if not cached
+                bool from_cache; // Restored from a binary
+            };
+            std::vector<PendingProgram> linking_;
+            // Context the driver was last told to compile shaders in
+            // parallel for
+            GLFWwindow *compiler_context_;
+            // Workers reading and processing files for background loads
+            ThreadPool loader_;
+            // Work left for the main thread by the workers
+            std::deque<std::function<void(void)> > upload_;
+            std::mutex upload_mutex_;
+            int pending_loads_;
+            // Texture shown while textures are loading
+            GLuint placeholder_texture_;
+            // Textures with finer levels left to upload
+            std::vector<std::shared_ptr<StreamedTexture> > streaming_;
+            // Items of the loaded manifests, and those waiting for their
+            // dependencies
+            std::unordered_map<std::string, ManifestItem> manifest_;
+            std::vector<std::string> manifest_waiting_;
  
             // Methods to load specific types of resources
             // Load shaders programs
-            void LoadMaterial(const std::string name, const char *prefix);
+            void LoadMaterial(const std::string name, const char *prefix, const char *vertex_extension = VERTEX_PROGRAM_EXTENSION);
+            // Start building a program, from the program cache or from
+            // source, without waiting for the driver
+            void BeginMaterial(const std::string name, const char *prefix, const char *vertex_extension);
+            void CompileProgram(PendingProgram &program);
+            // Check the programs begun so far and add them as materials
+            void FinishMaterials(void);
+            void FinishProgram(PendingProgram &program);
+            // Path of the cache file of a program; empty if caching is
+            // disabled
+            std::string GetProgramCachePath(const std::string name) const;
             // Load a text file into memory (could be source code)
             std::string LoadTextFile(const char *filename);
             // Load a texture from an image file: png, jpg, etc.
+            // The texture is complete after loading: mipmaps are built and
+            // filtering is set, so drawing only binds it
+            // If the image has a texture container, the container is used
+            // instead and its finer levels are streamed
             void LoadTexture(const std::string name, const char *filename);
+            // Map the container of an image file, if there is one
+            bool ReadTextureStream(const std::string filename, StreamedTexture &texture) const;
+            // Create the texture of a container with its coarse levels and
+            // queue the others for streaming
+            void StartTextureStream(Resource *res, std::shared_ptr<StreamedTexture> texture);
+            // Upload the next finer level of streamed textures; returns
+            // the number of levels uploaded
+            int StreamTextures(double time_budget);
+            void UploadTextureLevel(StreamedTexture &texture, int level);
+            // Create a texture with mipmaps from RGBA pixels
+            GLuint CreateTexture(const unsigned char *image, int width, int height);
+            GLuint GetPlaceholderTexture(void);
+            // Set filtering of 'texture': through the sampler shared by all
+            // textures on texture unit 0, or in the texture itself without
+            // sampler objects
+            void SetupSampler(GLuint texture);
             // Loads a mesh in obj format
             void LoadMesh(const std::string name, const char *filename);
+            // Parse an obj file into interleaved vertices and triangles
+            void ReadMesh(const char *filename, std::vector<GLfloat> &vertex, std::vector<GLuint> &face) const;
+            // Copy an interleaved vertex array and its triangle indices
+            // to new OpenGL buffers and add them as a mesh resource
+            // The arrays are optimized for the vertex cache first, and the
+            // vertices are packed in a compact format. The result is saved
+            // in the mesh cache under 'cache_key' unless it is 0
+            Resource *UploadMesh(const std::string name, std::vector<GLfloat> &vertex, std::vector<GLuint> &face, uint64_t cache_key = 0);
+            // Processing part of UploadMesh, without OpenGL calls; the
+            // indices are moved into 'mesh'
+            void ProcessMesh(const std::string name, std::vector<GLfloat> &vertex, std::vector<GLuint> &face, uint64_t cache_key, PackedMesh &mesh) const;
+            // Print the statistics of a processed mesh if verbose; on the
+            // main thread, so lines of parallel loads do not mix
+            void ReportMesh(const std::string name, const PackedMesh &mesh) const;
+            // Create buffers with final vertex and index data and add them
+            // as a mesh resource
+            Resource *CreateMesh(const std::string name, const VertexFormat &format, const Bounds &bounds, const void *vertex, size_t vertex_size, const GLuint *face, size_t index_num);
+            // Same for a mesh resource created with a placeholder
+            void FillMesh(Resource *res, const VertexFormat &format, const Bounds &bounds, const void *vertex, size_t vertex_size, const GLuint *face, size_t index_num);
+            void CreateMeshBuffers(const void *vertex, size_t vertex_size, const GLuint *face, size_t index_num, GLuint &array_buffer, GLuint &element_array_buffer);
+            // Worker side of background loads: read and process a file,
+            // then queue its upload
+            void ReadTextureAsync(Resource *res, const std::string filename);
+            void ReadMeshAsync(Resource *res, const std::string filename);
+            void QueueUpload(std::function<void(void)> upload);
+            // Mark a background load as failed, on the main thread, and
+            // fail the manifest items waiting for it so they stop waiting
+            void FailLoad(Resource *res);
+            // Register a resource holding a placeholder, and start reading
+            // its file on a worker
+            Resource *CreatePlaceholder(ResourceType type, const std::string name);
+            void StartBackgroundLoad(Resource *res, const std::string filename);
+            // Manifest loading: mark an item and its dependencies as
+            // wanted, start the wanted items whose dependencies are ready,
+            // and start one item
+            void RequestManifestItem(const std::string name);
+            void StartManifestItems(void);
+            void StartManifestItem(ManifestItem &item);
+            // Load a lazy item looked up for the first time; it starts once
+            // its dependencies are ready
+            void LoadLazyItem(const std::string name);
+            // Key of a mesh in the cache, from its source and the settings
+            // that affect processing
+            uint64_t MeshCacheKey(const char *source, const void *parameter, size_t size) const;
+            // Path of the cache file of a mesh; empty if caching is disabled
+            std::string GetMeshCachePath(const std::string name) const;
+            // Create a mesh from its cache file, if it is current
+            bool LoadCachedMesh(const std::string name, uint64_t key);
+            // Give a new resource a slot and index its name
+            void RegisterResource(Resource *res);
+            // Slot of the resource with a name, if it is of kind 'type'
+            bool FindSlot(const std::string name, ResourceType type, unsigned int &index, unsigned int &generation) const;
+            Resource *ResolveSlot(unsigned int index, unsigned int generation) const;
+            void UnloadSlot(unsigned int index);
+            // Change the memory of a resource, keeping the totals right
+            void SetResourceBytes(Resource *res, size_t bytes);
+            // Delete a resource and its OpenGL objects
+            void DeleteResource(Resource *res);
+            // Record the vertex layout of a mesh in a vertex array object
+            GLuint CreateVertexArray(GLuint array_buffer, GLuint element_array_buffer, const VertexFormat &format);
 
     }; // class ResourceManager
 
@@ -0,0 +1,155 @@
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdlib>
+
+#include "resource_manifest.h"
+
+namespace game {
+
+// Number of file arguments required by each kind; generators take
+// optional numbers instead
+static int RequiredArguments(const std::string &kind){
+
+    if ((kind == "material") || (kind == "instanced_material") ||
+        (kind == "texture") || (kind == "mesh")){
+        return 1;
+    }
+    if ((kind == "torus") || (kind == "sphere") ||
+        (kind == "cylinder") || (kind == "plane")){
+        return 0;
+    }
+    return -1;
+}
+
+
+// Depth-first search for a cycle through 'name'; 'mark' is 1 for items
+// on the current path and 2 for items already checked
+static void CheckCycles(const std::string &name, const std::unordered_map<std::string, const ManifestItem *> &index, std::unordered_map<std::string, int> &mark){
+
+    int &state = mark[name];
+    if (state == 2){
+        return;
+    }
+    if (state == 1){
+        throw(std::ios_base::failure(std::string("Error: dependency cycle through manifest item ")+name));
+    }
+    state = 1;
+    const ManifestItem *item = index.find(name)->second;
+    for (unsigned int i = 0; i < item->dependency.size(); i++){
+        CheckCycles(item->dependency[i], index, mark);
+    }
+    mark[name] = 2;
+}
+
+
+void LoadManifestFile(const char *filename, std::vector<ManifestItem> &item){
+
+    std::ifstream f;
+    f.open(filename);
+    if (f.fail()){
+        throw(std::ios_base::failure(std::string("Error opening file ")+std::string(filename)));
+    }
+
+    // Files are relative to the manifest
+    std::string directory(filename);
+    size_t slash = directory.find_last_of("/\\");
+    directory = (slash == std::string::npos) ? std::string(".") : directory.substr(0, slash);
+
+    // Names of the items read so far
+    std::unordered_set<std::string> name;
+    for (size_t i = 0; i < item.size(); i++){
+        name.insert(item[i].name);
+    }
+
+    std::string line;
+    int line_num = 0;
+    size_t first = item.size();
+    while (std::getline(f, line)){
+        line_num++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos){
+            line.erase(comment);
+        }
+        std::istringstream ss(line);
+        ManifestItem entry;
+        if (!(ss >> entry.kind)){
+            continue;
+        }
+        if (!(ss >> entry.name)){
+            throw(std::ios_base::failure(std::string("Error: missing name in ")+std::string(filename)+std::string(" line ")+std::to_string(line_num)));
+        }
+        if (!name.insert(entry.name).second){
+            throw(std::ios_base::failure(std::string("Error: duplicate item ")+entry.name+std::string(" in ")+std::string(filename)+std::string(" line ")+std::to_string(line_num)));
+        }
+        int required = RequiredArguments(entry.kind);
+        if (required < 0){
+            throw(std::ios_base::failure(std::string("Error: unknown resource kind ")+entry.kind+std::string(" in ")+std::string(filename)));
+        }
+
+        // Arguments, then flags and dependencies
+        entry.lazy = false;
+        bool after = false;
+        std::string word;
+        while (ss >> word){
+            if (after){
+                entry.dependency.push_back(word);
+            } else if (word == "lazy"){
+                entry.lazy = true;
+            } else if (word == "after"){
+                after = true;
+            } else {
+                entry.argument.push_back(word);
+            }
+        }
+        if ((int) entry.argument.size() < required){
+            throw(std::ios_base::failure(std::string("Error: missing file for ")+entry.name+std::string(" in ")+std::string(filename)));
+        }
+        entry.directory = directory;
+        entry.state = ManifestIdle;
+        item.push_back(entry);
+    }
+    f.close();
+
+    // Dependencies must name items of the manifest and must not loop
+    std::unordered_map<std::string, const ManifestItem *> index;
+    for (size_t i = first; i < item.size(); i++){
+        index[item[i].name] = &item[i];
+    }
+    for (size_t i = first; i < item.size(); i++){
+        for (unsigned int j = 0; j < item[i].dependency.size(); j++){
+            if (index.find(item[i].dependency[j]) == index.end()){
+                throw(std::ios_base::failure(std::string("Error: ")+item[i].name+std::string(" depends on unknown item ")+item[i].dependency[j]));
+            }
+        }
+    }
+    std::unordered_map<std::string, int> mark;
+    for (size_t i = first; i < item.size(); i++){
+        CheckCycles(item[i].name, index, mark);
+    }
+}
+
+
+std::string GetManifestPath(const ManifestItem &item, int index){
+
+    return item.directory + std::string("/") + item.argument[index];
+}
+
+
+float GetManifestNumber(const ManifestItem &item, int index, float value){
+
+    if (index >= (int) item.argument.size()){
+        return value;
+    }
+    const char *text = item.argument[index].c_str();
+    char *end;
+    float number = strtof(text, &end);
+    if ((end == text) || (*end != '\0')){
+        throw(std::ios_base::failure(std::string("Error: invalid number ")+item.argument[index]+std::string(" for ")+item.name));
+    }
+    return number;
+}
+
+} // namespace game
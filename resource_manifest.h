@@ -0,0 +1,51 @@
+#ifndef RESOURCE_MANIFEST_H_
+#define RESOURCE_MANIFEST_H_
+
+#include <string>
+#include <vector>
+
+namespace game {
+
+    // A manifest lists the resources of the game, one per line:
+    //
+    //   <kind> <name> <arguments...> [lazy] [after <name> <name>...]
+    //
+    // Kinds and their arguments:
+    //   material <prefix>, instanced_material <prefix>: shader programs
+    //   texture <file>, mesh <file.obj>
+    //   torus [loop_radius circle_radius loop_samples circle_samples]
+    //   sphere [radius theta_samples phi_samples]
+    //   cylinder [r g b], plane [r g b]: generated geometry
+    // Files and prefixes are relative to the directory of the manifest
+    // 'lazy' items are only loaded when their name is first looked up;
+    // 'after' lists items that must be ready before this one starts
+    // Everything after a '#' is a comment
+
+    // States of an item while it is loaded
+    // Items whose file could not be loaded fail, and so do the items
+    // waiting for them
+    typedef enum ManifestState { ManifestIdle, ManifestWaiting, ManifestStarted, ManifestFailed } ManifestItemState;
+
+    // One line of a manifest
+    struct ManifestItem {
+        std::string kind;
+        std::string name;
+        std::vector<std::string> argument;
+        std::vector<std::string> dependency;
+        std::string directory; // Directory of the manifest
+        bool lazy;
+        ManifestItemState state;
+    };
+
+    // Read a manifest; throws on unknown kinds, missing arguments,
+    // duplicate names, unknown dependencies and dependency cycles
+    void LoadManifestFile(const char *filename, std::vector<ManifestItem> &item);
+
+    // Path of a file argument of an item
+    std::string GetManifestPath(const ManifestItem &item, int index);
+    // Numeric argument of an item, or 'value' if it is not given
+    float GetManifestNumber(const ManifestItem &item, int index, float value);
+
+} // namespace game
+
+#endif // RESOURCE_MANIFEST_H_
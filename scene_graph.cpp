@@ -1,6 +1,7 @@
 #include <stdexcept>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 #define GLM_FORCE_RADIANS
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -13,6 +14,13 @@ namespace game {
 SceneGraph::SceneGraph(void){
 
     background_color_ = glm::vec3(0.0, 0.0, 0.0);
+    for (int i = 0; i < NUM_LIGHTS; i++){
+        light_position_[i] = glm::vec3(0.0, 0.0, 0.0);
+        material_light_position_[i] = glm::vec3(0.0, 0.0, 0.0);
+    }
+    globals_buffer_ = 0;
+    visible_count_ = 0;
+    culled_count_ = 0;
 }
 
 
@@ -30,6 +38,30 @@ glm::vec3 SceneGraph::GetBackgroundColor(void) const {
 
     return background_color_;
 }
+
+
+void SceneGraph::SetLightPosition(int light, glm::vec3 position){
+
+    light_position_[light] = position;
+}
+
+
+glm::vec3 SceneGraph::GetLightPosition(int light) const {
+
+    return light_position_[light];
+}
+
+
+void SceneGraph::SetMaterialLightPosition(int light, glm::vec3 position){
+
+    material_light_position_[light] = position;
+}
+
+
+glm::vec3 SceneGraph::GetMaterialLightPosition(int light) const {
+
+    return material_light_position_[light];
+}
  
 
 SceneNode *SceneGraph::CreateNode(std::string node_name, Resource *geometry, Resource *material, Resource *texture){
@@ -38,7 +70,7 @@ SceneNode *SceneGraph::CreateNode(std::string node_name, Resource *geometry, Res
     SceneNode *scn = new SceneNode(node_name, geometry, material, texture);
 
     // Add node to the scene
-    node_.push_back(scn);
+    AddNode(scn);
 
     return scn;
 
@@ -47,21 +79,135 @@ SceneNode *SceneGraph::CreateNode(std::string node_name, Resource *geometry, Res
 
 void SceneGraph::AddNode(SceneNode *node){
 
+    node->root_ = node_.size();
     node_.push_back(node);
+    RegisterNode(node);
 }
 
 
 SceneNode *SceneGraph::GetNode(std::string node_name) const {
 
     // Find node with the specified name
+    std::unordered_map<std::string, SceneNode *>::const_iterator it = index_.find(node_name);
+    if (it == index_.end()){
+        return NULL;
+    }
+    return it->second;
+}
+
+
+void SceneGraph::RegisterNode(SceneNode *node){
+
+    // A node is registered once, even if it is both a root and a child
+    if (node->graph_ == this){
+        return;
+    }
+
+    // Give the node a slot for handles, reusing the slot of a destroyed
+    // node if there is one; its generation was bumped then
+    if (!free_slot_.empty()){
+        node->slot_ = free_slot_.back();
+        free_slot_.pop_back();
+        slot_[node->slot_].node = node;
+    } else {
+        NodeSlot slot;
+        slot.node = node;
+        slot.generation = 1;
+        node->slot_ = slot_.size();
+        slot_.push_back(slot);
+    }
+    node->graph_ = this;
+
+    // Keep the first node with a given name, like the old search did
+    index_.insert(std::make_pair(node->GetName(), node));
+
+    // Children added before the node joined the scene
+    const std::vector<SceneNode *> &children = node->GetChildren();
+    for (int i = 0; i < children.size(); i++){
+        RegisterNode(children[i]);
+    }
+}
+
+
+void SceneGraph::DestroyNode(SceneNode *node){
+
+    if (node->destroyed_){
+        return;
+    }
+    node->destroyed_ = true;
+    destroy_.push_back(node);
+
+    // Children go with their parent
+    const std::vector<SceneNode *> &children = node->GetChildren();
+    for (int i = 0; i < children.size(); i++){
+        DestroyNode(children[i]);
+    }
+}
+
+
+void SceneGraph::FlushDestroyed(void){
+
+    // Unlink every node first: a destroyed child may point at a destroyed
+    // parent
+    for (int i = 0; i < destroy_.size(); i++){
+        SceneNode *node = destroy_[i];
+
+        // Leave a parent that stays in the scene
+        if (node->parent_ && !node->parent_->destroyed_){
+            std::vector<SceneNode *> &siblings = node->parent_->node_;
+            std::vector<SceneNode *>::iterator it = std::find(siblings.begin(), siblings.end(), node);
+            if (it != siblings.end()){
+                *it = siblings.back();
+                siblings.pop_back();
+            }
+        }
+
+        // Swap-remove from the roots; draw order does not matter, since
+        // the render queue sorts the draws
+        if (node->root_ >= 0){
+            SceneNode *last = node_.back();
+            node_[node->root_] = last;
+            last->root_ = node->root_;
+            node_.pop_back();
+            node->root_ = -1;
+        }
+
+        // Old handles stop resolving and the slot can be reused
+        if (node->graph_ == this){
+            slot_[node->slot_].node = NULL;
+            slot_[node->slot_].generation++;
+            free_slot_.push_back(node->slot_);
+            // Another live node with the same name takes the name over
+            std::unordered_map<std::string, SceneNode *>::iterator it = index_.find(node->GetName());
+            if ((it != index_.end()) && (it->second == node)){
+                index_.erase(it);
+                for (unsigned int j = 0; j < slot_.size(); j++){
+                    SceneNode *other = slot_[j].node;
+                    if (other && !other->destroyed_ && (other->GetName() == node->GetName())){
+                        index_.insert(std::make_pair(node->GetName(), other));
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < destroy_.size(); i++){
+        delete destroy_[i];
+    }
+    destroy_.clear();
+}
+
+
+bool SceneGraph::Clear(void){
+
     for (int i = 0; i < node_.size(); i++){
-		SceneNode *return_node = node_[i]->GetNode(node_name);
-		if (return_node) {
-			return return_node;
-		}
+        DestroyNode(node_[i]);
     }
-    return NULL;
+    FlushDestroyed();
 
+    // Every node is gone: new nodes fill the slabs from the start again
+    return SceneNode::ResetAllocators();
 }
 
 
@@ -77,25 +223,113 @@ std::vector<SceneNode *>::const_iterator SceneGraph::end() const {
 }
 
 
+void SceneGraph::UpdateTransforms(void){
+
+    // Switch nodes from placeholders to resources loaded since the last
+    // frame, before their bounds are refreshed
+    for (int i = 0; i < node_.size(); i++){
+        if (node_[i]->IsPending()){
+            node_[i]->UpdateResources();
+        }
+    }
+
+    // Single top-down pass: each root refreshes its own subtree
+    for (int i = 0; i < node_.size(); i++){
+        if (!node_[i]->HasParent()){
+            node_[i]->UpdateTransform();
+        }
+    }
+}
+
+
+void SceneGraph::UpdateGlobals(Camera *camera){
+
+    // Create the buffer on first use, when a context is available
+    if (!globals_buffer_){
+        glGenBuffers(1, &globals_buffer_);
+        glBindBuffer(GL_UNIFORM_BUFFER, globals_buffer_);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameGlobals), NULL, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_GLOBALS_BINDING, globals_buffer_);
+    }
+
+    FrameGlobals globals;
+    globals.view_mat = camera->GetViewMatrix();
+    globals.projection_mat = camera->GetProjectionMatrix();
+    globals.camera_position = glm::vec4(camera->GetPosition(), 1.0);
+    for (int i = 0; i < NUM_LIGHTS; i++){
+        globals.light_position[i] = glm::vec4(light_position_[i], 1.0);
+        globals.material_light_position[i] = glm::vec4(material_light_position_[i], 1.0);
+    }
+    // One timestamp for every node in the frame
+    globals.timer = glm::vec4((float) glfwGetTime(), 0.0, 0.0, 0.0);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, globals_buffer_);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameGlobals), &globals);
+}
+
+
 void SceneGraph::Draw(Camera *camera){
 
+    // Make sure world matrices are current before drawing
+    UpdateTransforms();
+
+    // Upload camera, lights and time once for all programs
+    UpdateGlobals(camera);
+
     // Clear background
     glClearColor(background_color_[0], 
                  background_color_[1],
                  background_color_[2], 0.0);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // Draw all scene nodes
+    // Queue the scene nodes inside the view volume and draw them grouped
+    // by render state
+    Frustum frustum = camera->GetFrustum();
+    glm::vec3 camera_pos = camera->GetPosition();
+    queue_.Clear();
+    visible_count_ = 0;
+    culled_count_ = 0;
     for (int i = 0; i < node_.size(); i++){
-        node_[i]->Draw(camera);
+        // Nothing to draw while the geometry is loading, nor for nodes
+        // about to be destroyed
+        if ((node_[i]->GetSize() == 0) || node_[i]->destroyed_){
+            continue;
+        }
+        float radius = node_[i]->GetBoundingRadius();
+        glm::vec3 center = node_[i]->GetBoundingCenter();
+        if (radius >= 0.0 && !frustum.Intersects(center, radius)){
+            culled_count_++;
+            continue;
+        }
+        visible_count_++;
+        glm::vec3 node_pos = glm::vec3(node_[i]->GetWorldMatrix()[3]);
+        queue_.Push(node_[i], glm::length(node_pos - camera_pos));
     }
+    queue_.Sort();
+    queue_.Submit();
+}
+
+
+int SceneGraph::GetVisibleCount(void) const {
+
+    return visible_count_;
+}
+
+
+int SceneGraph::GetCulledCount(void) const {
+
+    return culled_count_;
 }
 
 
 void SceneGraph::Update(void){
 
+    // Nodes may be destroyed while updating: they are only flagged, so the
+    // list does not change under the loop
     for (int i = 0; i < node_.size(); i++){
-        node_[i]->Update();
+        if (!node_[i]->destroyed_){
+            node_[i]->Update();
+        }
     }
 }
 
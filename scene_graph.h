@@ -2,6 +2,8 @@
 #define SCENE_GRAPH_H_
 
 #include <string>
+#include <vector>
+#include <unordered_map>
 #define GLEW_STATIC
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -9,6 +11,9 @@
 #include "scene_node.h"
 #include "resource.h"
 #include "camera.h"
+#include "handle.h"
+#include "render_queue.h"
+#include "frame_globals.h"
 
 namespace game {
 
@@ -19,9 +24,38 @@ namespace game {
             // Background color
             glm::vec3 background_color_;
 
+            // Light positions in world coordinates
+            glm::vec3 light_position_[NUM_LIGHTS];
+            glm::vec3 material_light_position_[NUM_LIGHTS];
+
+            // Uniform buffer with the per-frame shader constants
+            GLuint globals_buffer_;
+
             // Scene nodes to render
             std::vector<SceneNode *> node_;
 
+            // Slot of a registered node; the generation is bumped when the
+            // slot is reused so old handles stop resolving
+            struct NodeSlot {
+                SceneNode *node;
+                unsigned int generation;
+            };
+            std::vector<NodeSlot> slot_;
+            // Slots of destroyed nodes, reused by new nodes
+            std::vector<unsigned int> free_slot_;
+            // Nodes to destroy at the end of the frame
+            std::vector<SceneNode *> destroy_;
+
+            // Index from node name to node, covering roots and children
+            std::unordered_map<std::string, SceneNode *> index_;
+
+            // Draws of the current frame, sorted by render state
+            RenderQueue queue_;
+
+            // Culling statistics of the last frame
+            int visible_count_;
+            int culled_count_;
+
         public:
             // Constructor and destructor
             SceneGraph(void);
@@ -30,6 +64,15 @@ namespace game {
             // Background color
             void SetBackgroundColor(glm::vec3 color);
             glm::vec3 GetBackgroundColor(void) const;
+
+            // Lights
+            void SetLightPosition(int light, glm::vec3 position);
+            glm::vec3 GetLightPosition(int light) const;
+            // Lights of the metal, plastic, toon, shiny blue and plain
+            // textured materials, which are lit from other positions than
+            // the rest of the scene
+            void SetMaterialLightPosition(int light, glm::vec3 position);
+            glm::vec3 GetMaterialLightPosition(int light) const;
             
             // Create a scene node from two resources
             SceneNode *CreateNode(std::string node_name, Resource *geometry, Resource *material, Resource *texture = NULL);
@@ -37,18 +80,85 @@ namespace game {
             void AddNode(SceneNode *node);
             // Find a scene node with a specific name
             SceneNode *GetNode(std::string node_name) const;
+            // Make a node and its children reachable through GetNode and
+            // handles; called by AddNode and SceneNode::AddNode
+            void RegisterNode(SceneNode *node);
+            // Destroy a node and its children at the end of the frame
+            // The nodes are no longer drawn, and their handles stop
+            // resolving once FlushDestroyed() runs; pointers to them must
+            // not be kept past that. Safe to call while the scene updates
+            void DestroyNode(SceneNode *node);
+            template <typename T> void DestroyNode(Handle<T> handle);
+            // Unlink and delete the nodes destroyed during the frame; the
+            // cost follows the number of destroyed nodes
+            void FlushDestroyed(void);
+            // Delete every node at once, e.g. at the end of a level, and
+            // start the node slabs over. Returns false if nodes outside the
+            // scene are still alive, in which case their slabs are kept as
+            // they are
+            bool Clear(void);
+
+            // Handles that can be cached instead of looking nodes up by name
+            // Returns an empty handle if no node of type T has that name
+            template <typename T> Handle<T> GetHandle(std::string node_name) const;
+            // Resolve a handle, or NULL if the node is gone
+            template <typename T> T *GetNode(Handle<T> handle) const;
             // Get node const iterator
             std::vector<SceneNode *>::const_iterator begin() const;
             std::vector<SceneNode *>::const_iterator end() const;
 
+            // Refresh the cached transformations of nodes that moved
+            void UpdateTransforms(void);
+
+            // Write camera, lights and time to the uniform buffer shared by
+            // all shader programs
+            void UpdateGlobals(Camera *camera);
+
             // Draw the entire scene
             void Draw(Camera *camera);
 
+            // Nodes drawn and nodes rejected by frustum culling in the
+            // last frame
+            int GetVisibleCount(void) const;
+            int GetCulledCount(void) const;
+
             // Update entire scene
             void Update(void);
 
     }; // class SceneGraph
 
+
+    template <typename T> Handle<T> SceneGraph::GetHandle(std::string node_name) const {
+
+        T *node = dynamic_cast<T *>(GetNode(node_name));
+        if (!node){
+            return Handle<T>();
+        }
+        return Handle<T>(node->slot_, slot_[node->slot_].generation);
+    }
+
+
+    template <typename T> void SceneGraph::DestroyNode(Handle<T> handle){
+
+        T *node = GetNode(handle);
+        if (node){
+            DestroyNode(node);
+        }
+    }
+
+
+    template <typename T> T *SceneGraph::GetNode(Handle<T> handle) const {
+
+        if (handle.GetIndex() >= slot_.size()){
+            return NULL;
+        }
+        const NodeSlot &slot = slot_[handle.GetIndex()];
+        if (slot.generation != handle.GetGeneration()){
+            return NULL;
+        }
+        return static_cast<T *>(slot.node);
+    }
+
 } // namespace game
 
 #endif // SCENE_GRAPH_H_
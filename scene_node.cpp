@@ -3,12 +3,54 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
+#include <unordered_map>
 #include <time.h>
 
 #include "scene_node.h"
+#include "scene_graph.h"
+#include "slab_allocator.h"
 
 namespace game {
 
+// Allocators of nodes, by node size; never deleted, so nodes can be
+// freed at any point of the exit
+static std::unordered_map<size_t, SlabAllocator *> &GetNodeAllocators(void){
+
+    static std::unordered_map<size_t, SlabAllocator *> allocator;
+    return allocator;
+}
+
+
+void *SceneNode::operator new(size_t size){
+
+    SlabAllocator *&allocator = GetNodeAllocators()[size];
+    if (!allocator){
+        allocator = new SlabAllocator(size);
+    }
+    return allocator->Allocate();
+}
+
+
+void SceneNode::operator delete(void *block, size_t size){
+
+    // The virtual destructor passes the size of the actual node type
+    GetNodeAllocators()[size]->Free(block);
+}
+
+
+bool SceneNode::ResetAllocators(void){
+
+    bool reset = true;
+    std::unordered_map<size_t, SlabAllocator *> &allocator = GetNodeAllocators();
+    for (std::unordered_map<size_t, SlabAllocator *>::iterator it = allocator.begin(); it != allocator.end(); ++it){
+        if (!it->second->Reset()){
+            reset = false;
+        }
+    }
+    return reset;
+}
+
+
 SceneNode::SceneNode(const std::string name, const Resource *geometry, const Resource *material, const Resource *texture){
 
     // Set name of scene node
@@ -23,29 +65,44 @@ SceneNode::SceneNode(const std::string name, const Resource *geometry, const Res
         throw(std::invalid_argument(std::string("Invalid type of geometry")));
     }
 
-    array_buffer_ = geometry->GetArrayBuffer();
-    element_array_buffer_ = geometry->GetElementArrayBuffer();
-    size_ = geometry->GetSize();
+    geometry_ = geometry;
+    SetGeometry(geometry);
 
     // Set material (shader program)
     if (material->GetType() != Material){
         throw(std::invalid_argument(std::string("Invalid type of material")));
     }
 
+    material_resource_ = material;
     material_ = material->GetResource();
+    locations_ = material->GetLocations();
 
     // Set texture
+    texture_resource_ = texture;
     if (texture){
         texture_ = texture->GetResource();
     } else {
         texture_ = 0;
     }
 
+    // Resources still loading in the background are drawn with their
+    // placeholders until UpdateResources() picks up the actual data
+    pending_ = !geometry->IsReady() || (texture && !texture->IsReady());
+
+    // The resources stay loaded while the node uses them
+    AddResourceRefs();
+
     // Other attributes
     scale_ = glm::vec3(1.0, 1.0, 1.0);
 	parent_ = NULL;
 	forward_ = glm::vec3(0.0, 0.0, 1.0);
 	side_ = glm::vec3(1.0, 0.0, 0.0);
+	dirty_ = true;
+	bounding_radius_ = -1.0;
+	graph_ = NULL;
+	slot_ = -1;
+	root_ = -1;
+	destroyed_ = false;
 }
 
 SceneNode::SceneNode(const SceneNode &nodeCpy) {
@@ -63,38 +120,74 @@ SceneNode::SceneNode(const SceneNode &nodeCpy) {
 		throw(std::invalid_argument(std::string("Invalid type of geometry")));
 	}
 
+	geometry_ = nodeCpy.geometry_;
 	array_buffer_ = nodeCpy.array_buffer_;
 	element_array_buffer_ = nodeCpy.element_array_buffer_;
+	vertex_array_ = nodeCpy.vertex_array_;
 	size_ = nodeCpy.size_;
+	bounds_ = nodeCpy.bounds_;
 
 	// Set material (shader program)
 	if (nodeCpy.material_ != Material) {
 		throw(std::invalid_argument(std::string("Invalid type of material")));
 	}
 
+	material_resource_ = nodeCpy.material_resource_;
 	material_ = nodeCpy.material_;
+	locations_ = nodeCpy.locations_;
 
 	// Set texture
+	texture_resource_ = nodeCpy.texture_resource_;
 	if (nodeCpy.texture_) {
 		texture_ = nodeCpy.texture_;
 	}
 	else {
 		texture_ = 0;
 	}
+	pending_ = nodeCpy.pending_;
+	AddResourceRefs();
 
 	// Other attributes
 	scale_ = glm::vec3(1.0, 1.0, 1.0);
 	parent_ = NULL;
 	forward_ = glm::vec3(0.0, 0.0, 1.0);
 	side_ = glm::vec3(1.0, 0.0, 0.0);
+	dirty_ = true;
+	bounding_radius_ = -1.0;
+	graph_ = NULL;
+	slot_ = -1;
+	root_ = -1;
+	destroyed_ = false;
 }
 
 
 SceneNode::~SceneNode(){
+
+    geometry_->Release();
+    material_resource_->Release();
+    if (texture_resource_){
+        texture_resource_->Release();
+    }
+}
+
+
+bool SceneNode::IsDestroyed(void) const {
+
+    return destroyed_;
 }
 
 
-const std::string SceneNode::GetName(void) const {
+void SceneNode::AddResourceRefs(void){
+
+    geometry_->AddRef();
+    material_resource_->AddRef();
+    if (texture_resource_){
+        texture_resource_->AddRef();
+    }
+}
+
+
+const std::string &SceneNode::GetName(void) const {
 
     return name_;
 }
@@ -125,28 +218,33 @@ glm::vec3 SceneNode::GetScale(void) const {
 void SceneNode::SetPosition(glm::vec3 position){
 
     position_ = position;
+    Invalidate();
 }
 
 
 void SceneNode::SetOrientation(glm::quat orientation){
 
     orientation_ = orientation;
+    Invalidate();
 }
 
 void SceneNode::SetOrbit(glm::vec3 orbit) {
 
 	orbit_ = orbit;
+	Invalidate();
 }
 
 void SceneNode::SetScale(glm::vec3 scale){
 
     scale_ = scale;
+    Invalidate();
 }
 
 
 void SceneNode::Translate(glm::vec3 trans){
 
     position_ += trans;
+    Invalidate();
 }
 
 
@@ -154,12 +252,14 @@ void SceneNode::Rotate(glm::quat rot){
 
     orientation_ *= rot;
     orientation_ = glm::normalize(orientation_);
+    Invalidate();
 }
 
 
 void SceneNode::Scale(glm::vec3 scale){
 
     scale_ *= scale;
+    Invalidate();
 }
 
 glm::vec3 SceneNode::GetForward(void) const {
@@ -191,6 +291,7 @@ void SceneNode::Pitch(float angle) {
 	glm::quat rotation = glm::angleAxis(angle, GetSide());
 	orientation_ = rotation * orientation_;
 	orientation_ = glm::normalize(orientation_);
+	Invalidate();
 }
 
 
@@ -199,6 +300,7 @@ void SceneNode::Yaw(float angle) {
 	glm::quat rotation = glm::angleAxis(angle, GetUp());
 	orientation_ = rotation * orientation_;
 	orientation_ = glm::normalize(orientation_);
+	Invalidate();
 }
 
 
@@ -207,6 +309,7 @@ void SceneNode::Roll(float angle) {
 	glm::quat rotation = glm::angleAxis(angle, GetForward());
 	orientation_ = rotation * orientation_;
 	orientation_ = glm::normalize(orientation_);
+	Invalidate();
 }
 
 
@@ -228,6 +331,12 @@ GLuint SceneNode::GetElementArrayBuffer(void) const {
 }
 
 
+GLuint SceneNode::GetVertexArray(void) const {
+
+    return vertex_array_;
+}
+
+
 GLsizei SceneNode::GetSize(void) const {
 
     return size_;
@@ -240,26 +349,39 @@ GLuint SceneNode::GetMaterial(void) const {
 }
 
 
-void SceneNode::Draw(Camera *camera){
+GLuint SceneNode::GetTexture(void) const {
+
+    return texture_;
+}
+
+
+const ShaderLocations *SceneNode::GetLocations(void) const {
+
+    return locations_;
+}
+
+
+void SceneNode::Draw(void){
 
-    // Select proper material (shader program)
+    // Select proper material (shader program); camera, lights and time
+    // come from the frame uniform buffer written by the scene graph
     glUseProgram(material_);
 
-    // Set geometry to draw
-    glBindBuffer(GL_ARRAY_BUFFER, array_buffer_);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_array_buffer_);
+    // Set geometry and texture to draw
+    BindGeometry();
+    BindTexture();
 
-    // Set globals for camera
-    camera->SetupShader(material_);
+    // Set world matrix and draw
+    DrawBound();
+
+    glBindVertexArray(0);
+}
+
+
+void SceneNode::DrawBound(void){
 
     // Set world matrix and other shader input variables
-    SetupShader(material_);
-	// Camera Position
-	GLint camVec = glGetUniformLocation(material_, "cameraPos");
-	glm::vec3 camera_pos = camera->GetPosition();
-	float camera_in[3]; camera_in[0] = camera_pos.x; camera_in[1] = camera_pos.x; camera_in[2] = camera_pos.x;
-	
-	glUniform3fvARB(camVec, 1, camera_in);
+    SetupShader();
 
     // Draw geometry
     if (mode_ == GL_POINTS){
@@ -269,8 +391,64 @@ void SceneNode::Draw(Camera *camera){
     }
 }
 
+
+void SceneNode::BindGeometry(void){
+
+    // Set geometry to draw; the vertex array holds the buffers and the
+    // attribute layout
+    glBindVertexArray(vertex_array_);
+}
+
+
+void SceneNode::BindTexture(void){
+
+    // Texture; texture_map is set to the first texture unit when the
+    // material is loaded, and mipmaps and filtering when the texture is
+    if (texture_){
+        glBindTexture(GL_TEXTURE_2D, texture_);
+    }
+}
+
+bool SceneNode::IsPending(void) const {
+
+    return pending_;
+}
+
+
+void SceneNode::UpdateResources(void){
+
+    // Wait until every resource of the node is loaded
+    if (!geometry_->IsReady() || (texture_resource_ && !texture_resource_->IsReady())){
+        return;
+    }
+
+    SetGeometry(geometry_);
+    if (texture_resource_){
+        texture_ = texture_resource_->GetResource();
+    }
+    pending_ = false;
+
+    // The bounds changed with the geometry
+    Invalidate();
+}
+
+
+void SceneNode::SetGeometry(const Resource *geometry){
+
+    array_buffer_ = geometry->GetArrayBuffer();
+    element_array_buffer_ = geometry->GetElementArrayBuffer();
+    vertex_array_ = geometry->GetVertexArray();
+    size_ = geometry->GetSize();
+    bounds_ = geometry->GetBounds();
+}
+
+
 void SceneNode::ChangeMaterial(Resource *material) {
+	material->AddRef();
+	material_resource_->Release();
+	material_resource_ = material;
 	material_ = material->GetResource();
+	locations_ = material->GetLocations();
 }
 
 
@@ -282,6 +460,10 @@ void SceneNode::Update(void){
 void SceneNode::AddNode(SceneNode *node) {
 	node_.push_back(node);
 	node->SetParent(this);
+	// Children of a node in the scene become visible to lookups as well
+	if (graph_) {
+		graph_->RegisterNode(node);
+	}
 }
 
 SceneNode *SceneNode::GetNode(std::string node_name){
@@ -299,6 +481,10 @@ SceneNode *SceneNode::GetNode(std::string node_name){
 
 }
 
+const std::vector<SceneNode *> &SceneNode::GetChildren(void) const {
+	return node_;
+}
+
 SceneNode *SceneNode::GetParent(){
 	if (parent_) {
 		return parent_;
@@ -306,80 +492,80 @@ SceneNode *SceneNode::GetParent(){
 	return this;
 }
 
+bool SceneNode::HasParent(void) const {
+	return parent_ != NULL;
+}
+
 void SceneNode::SetParent(SceneNode *parent) {
 	parent_ = parent;
+	Invalidate();
 }
 
 glm::mat4 SceneNode::GetHierarchy() {
-	glm::mat4 returnMat = glm::mat4(1.0);
-	if (parent_) {
-		returnMat = parent_->GetHierarchy();
-	}
-	returnMat = glm::translate(returnMat, position_);
-	returnMat *= glm::mat4_cast(orientation_);
-	returnMat = glm::translate(returnMat, orbit_);
-	return returnMat;
+	return hierarchy_;
 }
 
-void SceneNode::SetupShader(GLuint program){
+glm::mat4 SceneNode::GetWorldMatrix(void) const {
+	return world_matrix_;
+}
 
-    // Set attributes for shaders
-    GLint vertex_att = glGetAttribLocation(program, "vertex");
-    glVertexAttribPointer(vertex_att, 3, GL_FLOAT, GL_FALSE, 11*sizeof(GLfloat), 0);
-    glEnableVertexAttribArray(vertex_att);
+glm::vec3 SceneNode::GetBoundingCenter(void) const {
+	return bounding_center_;
+}
 
-    GLint normal_att = glGetAttribLocation(program, "normal");
-    glVertexAttribPointer(normal_att, 3, GL_FLOAT, GL_FALSE, 11*sizeof(GLfloat), (void *) (3*sizeof(GLfloat)));
-    glEnableVertexAttribArray(normal_att);
+float SceneNode::GetBoundingRadius(void) const {
+	return bounding_radius_;
+}
 
-    GLint color_att = glGetAttribLocation(program, "color");
-    glVertexAttribPointer(color_att, 3, GL_FLOAT, GL_FALSE, 11*sizeof(GLfloat), (void *) (6*sizeof(GLfloat)));
-    glEnableVertexAttribArray(color_att);
+void SceneNode::Invalidate(void) {
+	dirty_ = true;
+}
 
-    GLint tex_att = glGetAttribLocation(program, "uv");
-    glVertexAttribPointer(tex_att, 2, GL_FLOAT, GL_FALSE, 11*sizeof(GLfloat), (void *) (9*sizeof(GLfloat)));
-    glEnableVertexAttribArray(tex_att);
+void SceneNode::UpdateTransform(bool parent_dirty) {
+	bool changed = dirty_ || parent_dirty;
 
-    // World transformation
-	glm::mat4 transf = glm::mat4(1.0);
-    glm::mat4 scaling = glm::scale(glm::mat4(1.0), scale_);
-    glm::mat4 rotation = glm::mat4_cast(orientation_);
-    glm::mat4 translation = glm::translate(glm::mat4(1.0), position_);
-	if (parent_) {
-		transf = parent_->GetHierarchy();
+	// Rebuild the local part only when this node moved; a moving parent
+	// just needs the product with the new hierarchy
+	if (dirty_) {
+		local_matrix_ = glm::translate(glm::mat4(1.0), position_);
+		local_matrix_ *= glm::mat4_cast(orientation_);
+		local_matrix_ = glm::translate(local_matrix_, orbit_);
+	}
+	if (changed) {
+		if (parent_) {
+			hierarchy_ = parent_->hierarchy_ * local_matrix_;
+		} else {
+			hierarchy_ = local_matrix_;
+		}
+		// Scale is not inherited by children
+		world_matrix_ = glm::scale(hierarchy_, scale_);
+		normal_matrix_ = glm::transpose(glm::inverse(world_matrix_));
+
+		// Move the bounding sphere with the node; the largest axis scale
+		// keeps it conservative under non-uniform scaling
+		bounding_center_ = glm::vec3(world_matrix_ * glm::vec4(bounds_.center, 1.0));
+		if (bounds_.radius < 0.0) {
+			bounding_radius_ = -1.0;
+		} else {
+			float axis_scale = glm::max(glm::length(glm::vec3(world_matrix_[0])),
+				glm::max(glm::length(glm::vec3(world_matrix_[1])), glm::length(glm::vec3(world_matrix_[2]))));
+			bounding_radius_ = bounds_.radius * axis_scale;
+		}
+		dirty_ = false;
 	}
 
-	transf = glm::translate(transf, position_);
-	transf *= glm::mat4_cast(orientation_);
-	transf = glm::translate(transf, orbit_);
-	transf = glm::scale(transf, scale_);
-    //glm::mat4 transf = translation * rotation * scaling;
-
-    GLint world_mat = glGetUniformLocation(program, "world_mat");
-    glUniformMatrix4fv(world_mat, 1, GL_FALSE, glm::value_ptr(transf));
-
-    // Normal matrix
-    glm::mat4 normal_matrix = glm::transpose(glm::inverse(transf));
-    GLint normal_mat = glGetUniformLocation(program, "normal_mat");
-    glUniformMatrix4fv(normal_mat, 1, GL_FALSE, glm::value_ptr(normal_matrix));
+	for (int i = 0; i < node_.size(); i++) {
+		node_[i]->UpdateTransform(changed);
+	}
+}
 
-    // Texture
-    if (texture_){
-        GLint tex = glGetUniformLocation(program, "texture_map");
-        glUniform1i(tex, 0); // Assign the first texture to the map
-        glActiveTexture(GL_TEXTURE0); 
-        glBindTexture(GL_TEXTURE_2D, texture_); // First texture we bind
-        // Define texture interpolation
-        glGenerateMipmap(GL_TEXTURE_2D);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    }
+void SceneNode::SetupShader(void){
 
-    // Timer
-    GLint timer_var = glGetUniformLocation(program, "timer");
-    double current_time = glfwGetTime();
-    glUniform1f(timer_var, (float) current_time);
+    // World transformation, refreshed by UpdateTransform()
+    glUniformMatrix4fv(locations_->world_mat, 1, GL_FALSE, glm::value_ptr(world_matrix_));
 
+    // Normal matrix
+    glUniformMatrix4fv(locations_->normal_mat, 1, GL_FALSE, glm::value_ptr(normal_matrix_));
 }
 
 } // namespace game;
@@ -17,6 +17,8 @@
 
 namespace game {
 
+    class SceneGraph;
+
     // Class that manages one object in a scene 
     class SceneNode {
 
@@ -24,11 +26,24 @@ namespace game {
             // Create scene node from given resources
             SceneNode(const std::string name, const Resource *geometry, const Resource *material, const Resource *texture = NULL);
 			SceneNode(const SceneNode &nodeCpy);
-            // Destructor
-            ~SceneNode();
+            // Destructor; nodes in a scene graph are destroyed through
+            // SceneGraph::DestroyNode()
+            virtual ~SceneNode();
+
+            // Nodes of every type are allocated from slabs, one allocator
+            // per node size, so nodes of a type lie next to each other
+            // The size is all operator new is told about the node; keying by
+            // size gives each node layout its own slabs without every
+            // derived class declaring its own operators
+            static void *operator new(size_t size);
+            static void operator delete(void *block, size_t size);
+            // Lay the next nodes out from the start of the slabs again.
+            // Returns false if some node is still alive; the slabs holding
+            // live nodes are left as they are
+            static bool ResetAllocators(void);
             
             // Get name of node
-            const std::string GetName(void) const;
+            const std::string &GetName(void) const;
 
             // Get node attributes
             glm::vec3 GetPosition(void) const;
@@ -36,7 +51,14 @@ namespace game {
 			glm::vec3 GetOrbit(void) const;
             glm::vec3 GetScale(void) const;
 			SceneNode *GetParent(void);
+			bool HasParent(void) const;
 			glm::mat4 GetHierarchy();
+			glm::mat4 GetWorldMatrix(void) const;
+			// Bounding sphere of the geometry in world coordinates,
+			// refreshed by UpdateTransform(); a negative radius means the
+			// node has no known extent and is never culled
+			glm::vec3 GetBoundingCenter(void) const;
+			float GetBoundingRadius(void) const;
 			glm::vec3 GetForward(void) const;
 			glm::vec3 GetSide(void) const;
 			glm::vec3 GetUp(void) const;
@@ -56,35 +78,67 @@ namespace game {
             void Rotate(glm::quat rot);
             void Scale(glm::vec3 scale);
 
-            // Draw the node according to scene parameters in 'camera'
-            // variable
-            virtual void Draw(Camera *camera);
+            // Draw the node on its own; camera, lights and time come from
+            // the frame uniform buffer written by the scene graph
+            virtual void Draw(void);
+            // Set per-node shader variables and issue the draw call,
+            // assuming material, geometry and texture are already bound
+            virtual void DrawBound(void);
+            // Bind the geometry and texture of the node
+            void BindGeometry(void);
+            void BindTexture(void);
 			// Change material for drawing
 			void ChangeMaterial(Resource *material);
+			// Whether the node still uses placeholders for resources that
+			// are loading in the background
+			bool IsPending(void) const;
+			// Whether the node is waiting to be destroyed at the end of
+			// the frame
+			bool IsDestroyed(void) const;
+			// Copy the objects of resources that finished loading
+			void UpdateResources(void);
 
             // Update the node
             virtual void Update(void);
 
+			// Cached transformations
+			// Mark the transformation of the node as changed
+			void Invalidate(void);
+			// Recompute the cached matrices of this node and its children
+			// if they changed since the last call
+			void UpdateTransform(bool parent_dirty = false);
+
 			// Node children
 			// Add an already-created node
 			void AddNode(SceneNode *node);
 			// Find a scene node with a specific name
 			SceneNode *GetNode(std::string node_name);
+			// Get the direct children of the node
+			const std::vector<SceneNode *> &GetChildren(void) const;
 
             // OpenGL variables
             GLenum GetMode(void) const;
             GLuint GetArrayBuffer(void) const;
             GLuint GetElementArrayBuffer(void) const;
+            GLuint GetVertexArray(void) const;
             GLsizei GetSize(void) const;
             GLuint GetMaterial(void) const;
+            GLuint GetTexture(void) const;
+            const ShaderLocations *GetLocations(void) const;
 
 		protected:
 			std::string name_; // Name of the scene node
 			GLuint material_; // Reference to shader program
+			const ShaderLocations *locations_; // Input locations of the program
 			GLuint texture_; // Reference to texture resource
+			const Resource *geometry_; // Resources the references come from
+			const Resource *material_resource_;
+			const Resource *texture_resource_;
+			bool pending_; // Some resource is not loaded yet
 			GLenum mode_; // Type of geometry
 			GLuint array_buffer_; // References to geometry: vertex and array buffers
 			GLuint element_array_buffer_;
+			GLuint vertex_array_; // Vertex array object of the geometry
 			GLsizei size_; // Number of primitives in geometry
 			glm::vec3 forward_; // Initial forward vector
 			glm::vec3 side_; // Initial side vector
@@ -93,14 +147,39 @@ namespace game {
 			glm::vec3 orbit_; // Orbital offset of node
 			glm::vec3 scale_; // Scale of node
 			SceneNode *parent_;
+			glm::mat4 local_matrix_; // Cached translation, rotation and orbit of node
+			glm::mat4 hierarchy_; // Cached transformation inherited by children
+			glm::mat4 world_matrix_; // Cached world transformation, including scale
+			glm::mat4 normal_matrix_; // Cached normal matrix
+			Bounds bounds_; // Extent of the geometry in object coordinates
+			glm::vec3 bounding_center_; // Cached bounding sphere in world coordinates
+			float bounding_radius_;
+			bool dirty_; // Local transformation changed since last update
+
+			// Copy the buffers, vertex array, size and bounds of a geometry
+			virtual void SetGeometry(const Resource *geometry);
 
         private:
+			friend class SceneGraph;
 			
 			// Scene nodes to render
 			std::vector<SceneNode *> node_;
 
-            // Set matrices that transform the node in a shader program
-            void SetupShader(GLuint program);
+			// Scene graph whose index this node is registered in
+			SceneGraph *graph_;
+			// Slot of the node in the scene graph, used to build handles
+			int slot_;
+			// Position in the node list of the scene graph, which holds
+			// every node added with CreateNode or AddNode, even once it
+			// has a parent; -1 for nodes only added as children
+			int root_;
+			// Flagged by SceneGraph::DestroyNode()
+			bool destroyed_;
+
+            // Set matrices that transform the node in its shader program
+            void SetupShader(void);
+            // Count the node as a user of its resources
+            void AddResourceRefs(void);
 
     }; // class SceneNode
 
@@ -0,0 +1,85 @@
+#include <vector>
+
+#include "shader_locations.h"
+
+namespace game {
+
+// Array uniforms are reported as "name[0]"; index them by their base name
+static std::string BaseName(const char *name, GLsizei length){
+
+    std::string base(name, length);
+    if (base.size() > 3 && base.compare(base.size() - 3, 3, "[0]") == 0){
+        base.erase(base.size() - 3);
+    }
+    return base;
+}
+
+
+ShaderLocations::ShaderLocations(GLuint program){
+
+    GLint count, max_length;
+    GLsizei length;
+    GLint size;
+    GLenum type;
+
+    // Uniforms
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+    std::vector<char> name(max_length + 1);
+    for (GLint i = 0; i < count; i++){
+        glGetActiveUniform(program, i, max_length + 1, &length, &size, &type, &name[0]);
+        GLint location = glGetUniformLocation(program, &name[0]);
+        // Uniforms in blocks have no location
+        if (location >= 0){
+            uniform_[BaseName(&name[0], length)] = location;
+        }
+    }
+
+    // Attributes
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &max_length);
+    name.resize(max_length + 1);
+    for (GLint i = 0; i < count; i++){
+        glGetActiveAttrib(program, i, max_length + 1, &length, &size, &type, &name[0]);
+        GLint location = glGetAttribLocation(program, &name[0]);
+        if (location >= 0){
+            attribute_[std::string(&name[0], length)] = location;
+        }
+    }
+
+    // Inputs the engine sets on every draw
+    vertex = GetAttribute("vertex");
+    normal = GetAttribute("normal");
+    color = GetAttribute("color");
+    uv = GetAttribute("uv");
+
+    world_mat = GetUniform("world_mat");
+    normal_mat = GetUniform("normal_mat");
+    texture_map = GetUniform("texture_map");
+}
+
+
+ShaderLocations::~ShaderLocations(){
+}
+
+
+GLint ShaderLocations::GetUniform(const std::string &name) const {
+
+    std::map<std::string, GLint>::const_iterator it = uniform_.find(name);
+    if (it == uniform_.end()){
+        return -1;
+    }
+    return it->second;
+}
+
+
+GLint ShaderLocations::GetAttribute(const std::string &name) const {
+
+    std::map<std::string, GLint>::const_iterator it = attribute_.find(name);
+    if (it == attribute_.end()){
+        return -1;
+    }
+    return it->second;
+}
+
+} // namespace game
@@ -0,0 +1,47 @@
+#ifndef SHADER_LOCATIONS_H_
+#define SHADER_LOCATIONS_H_
+
+#include <string>
+#include <map>
+#define GLEW_STATIC
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+namespace game {
+
+    // Locations of the attributes and uniforms of a linked shader program
+    // They are queried once when the program is loaded, so drawing does
+    // not need any string lookups in the driver
+    class ShaderLocations {
+
+        public:
+            // Query all active attributes and uniforms of 'program'
+            ShaderLocations(GLuint program);
+            ~ShaderLocations();
+
+            // Location of any active uniform or attribute, or -1 if the
+            // program does not use it
+            GLint GetUniform(const std::string &name) const;
+            GLint GetAttribute(const std::string &name) const;
+
+            // Vertex attributes
+            GLint vertex;
+            GLint normal;
+            GLint color;
+            GLint uv;
+
+            // Uniforms set by the engine
+            GLint world_mat;
+            GLint normal_mat;
+            GLint texture_map;
+
+        private:
+            // All active uniforms and attributes, by name
+            std::map<std::string, GLint> uniform_;
+            std::map<std::string, GLint> attribute_;
+
+    }; // class ShaderLocations
+
+} // namespace game
+
+#endif // SHADER_LOCATIONS_H_
@@ -0,0 +1,107 @@
+#include <new>
+
+#include "slab_allocator.h"
+
+namespace game {
+
+SlabAllocator::SlabAllocator(size_t block_size, int block_num){
+
+    // Every block is aligned like memory from operator new, and can hold
+    // the free list link
+    size_t align = alignof(std::max_align_t);
+    if (block_size < sizeof(void *)){
+        block_size = sizeof(void *);
+    }
+    block_size_ = (block_size + align - 1) / align * align;
+    block_num_ = block_num;
+    free_ = NULL;
+    slab_index_ = 0;
+    block_index_ = 0;
+    live_ = 0;
+}
+
+
+SlabAllocator::~SlabAllocator(){
+
+    // Blocks still in use at exit are left to the process, like objects
+    // that were never deleted
+    if (live_ == 0){
+        Release();
+    }
+}
+
+
+void *SlabAllocator::Allocate(void){
+
+    live_++;
+
+    // Reuse a freed block first
+    if (free_){
+        void *block = free_;
+        free_ = *(void **) block;
+        return block;
+    }
+
+    // Then the next untouched block, adding a slab when all are used
+    if (block_index_ == block_num_){
+        slab_index_++;
+        block_index_ = 0;
+    }
+    if (slab_index_ == (int) slab_.size()){
+        slab_.push_back((unsigned char *) ::operator new(block_size_ * block_num_));
+    }
+    return slab_[slab_index_] + block_size_ * block_index_++;
+}
+
+
+void SlabAllocator::Free(void *block){
+
+    *(void **) block = free_;
+    free_ = block;
+    live_--;
+}
+
+
+bool SlabAllocator::Reset(void){
+
+    if (live_ != 0){
+        return false;
+    }
+    free_ = NULL;
+    slab_index_ = 0;
+    block_index_ = 0;
+    return true;
+}
+
+
+bool SlabAllocator::Release(void){
+
+    if (!Reset()){
+        return false;
+    }
+    for (unsigned int i = 0; i < slab_.size(); i++){
+        ::operator delete(slab_[i]);
+    }
+    slab_.clear();
+    return true;
+}
+
+
+size_t SlabAllocator::GetBlockSize(void) const {
+
+    return block_size_;
+}
+
+
+int SlabAllocator::GetLiveCount(void) const {
+
+    return live_;
+}
+
+
+int SlabAllocator::GetSlabCount(void) const {
+
+    return slab_.size();
+}
+
+} // namespace game
@@ -0,0 +1,57 @@
+#ifndef SLAB_ALLOCATOR_H_
+#define SLAB_ALLOCATOR_H_
+
+#include <vector>
+#include <cstddef>
+
+// Blocks carved from each slab; a slab of scene nodes is a few tens of
+// kilobytes
+#define SLAB_BLOCK_NUM 64
+
+namespace game {
+
+    // Fixed-size blocks carved in order from large slabs
+    // Freed blocks go to a free list and are reused first; once every block
+    // is free, Reset() makes all slabs new again with one assignment, so
+    // the next objects are laid out in order again
+    // Not thread-safe: meant for objects of the main thread
+    class SlabAllocator {
+
+        public:
+            // Constructor and destructor
+            SlabAllocator(size_t block_size, int block_num = SLAB_BLOCK_NUM);
+            ~SlabAllocator();
+
+            void *Allocate(void);
+            void Free(void *block);
+
+            // Start again from the first block of the first slab; only
+            // when no block is in use. Returns false otherwise
+            bool Reset(void);
+            // Give the slabs back to the heap; only when no block is in use
+            bool Release(void);
+
+            size_t GetBlockSize(void) const;
+            int GetLiveCount(void) const;
+            int GetSlabCount(void) const;
+
+        private:
+            size_t block_size_;
+            int block_num_;
+            std::vector<unsigned char *> slab_;
+            // Freed blocks, each holding the next one
+            void *free_;
+            // Slab and block where untouched blocks start
+            int slab_index_;
+            int block_index_;
+            int live_;
+
+            // Slabs are not copied
+            SlabAllocator(const SlabAllocator &);
+            SlabAllocator &operator=(const SlabAllocator &);
+
+    }; // class SlabAllocator
+
+} // namespace game
+
+#endif // SLAB_ALLOCATOR_H_
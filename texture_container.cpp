@@ -0,0 +1,363 @@
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+#include "texture_container.h"
+
+namespace game {
+
+size_t TextureLevelSize(TextureFormat format, int width, int height){
+
+    if (format == TextureRGBA8){
+        return (size_t) width * height * 4;
+    }
+    size_t block_num = (size_t) ((width + 3) / 4) * ((height + 3) / 4);
+    return block_num * ((format == TextureBC1) ? 8 : 16);
+}
+
+
+GLenum TextureInternalFormat(TextureFormat format){
+
+    if (format == TextureBC1){
+        return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    }
+    if (format == TextureBC3){
+        return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    }
+    return GL_RGBA8;
+}
+
+
+std::string GetTextureContainerPath(const std::string &filename){
+
+    size_t dot = filename.find_last_of('.');
+    size_t slash = filename.find_last_of("/\\");
+    if ((dot == std::string::npos) || ((slash != std::string::npos) && (dot < slash))){
+        return filename + std::string(TEXTURE_CONTAINER_EXTENSION);
+    }
+    return filename.substr(0, dot) + std::string(TEXTURE_CONTAINER_EXTENSION);
+}
+
+
+bool ReadTextureContainer(const std::string &filename, TextureContainer &container){
+
+    if (!container.file.Open(filename)){
+        return false;
+    }
+
+    // Check the header and that every level lies in the file with the
+    // size its format requires
+    const unsigned char *data = container.file.GetData();
+    size_t size = container.file.GetSize();
+    TextureContainerHeader header;
+    if (size < sizeof(header)){
+        container.file.Close();
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if ((header.magic != TEXTURE_CONTAINER_MAGIC) || (header.version != TEXTURE_CONTAINER_VERSION) ||
+        (header.format > TextureBC3) || (header.level_num == 0) || (header.level_num > 32) ||
+        (size < sizeof(header) + header.level_num * sizeof(TextureLevel))){
+        container.file.Close();
+        return false;
+    }
+    container.format = (TextureFormat) header.format;
+    container.level.resize(header.level_num);
+    memcpy(&container.level[0], data + sizeof(header), header.level_num * sizeof(TextureLevel));
+    int width = header.width;
+    int height = header.height;
+    for (unsigned int i = 0; i < header.level_num; i++){
+        const TextureLevel &level = container.level[i];
+        if ((level.width != width) || (level.height != height) ||
+            (level.size != TextureLevelSize(container.format, width, height)) ||
+            (level.offset > size) || (level.size > size - level.offset)){
+            container.file.Close();
+            return false;
+        }
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+    return true;
+}
+
+
+const unsigned char *GetTextureLevelData(const TextureContainer &container, int level){
+
+    return container.file.GetData() + container.level[level].offset;
+}
+
+
+void WriteTextureContainer(const std::string &filename, TextureFormat format, int width, int height, const std::vector<std::vector<unsigned char> > &data){
+
+    TextureContainerHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = TEXTURE_CONTAINER_MAGIC;
+    header.version = TEXTURE_CONTAINER_VERSION;
+    header.format = format;
+    header.width = width;
+    header.height = height;
+    header.level_num = data.size();
+
+    std::vector<TextureLevel> level(data.size());
+    uint64_t offset = sizeof(header) + data.size() * sizeof(TextureLevel);
+    for (unsigned int i = 0; i < data.size(); i++){
+        level[i].width = width;
+        level[i].height = height;
+        level[i].offset = offset;
+        level[i].size = data[i].size();
+        offset += data[i].size();
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+
+    // Write to a temporary file and rename it, like the mesh cache
+    std::string temporary = filename + ".tmp";
+    std::ofstream f(temporary.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (f.fail()){
+        throw(std::ios_base::failure(std::string("Error opening file ")+temporary));
+    }
+    f.write((const char *) &header, sizeof(header));
+    f.write((const char *) &level[0], level.size() * sizeof(TextureLevel));
+    for (unsigned int i = 0; i < data.size(); i++){
+        f.write((const char *) &data[i][0], data[i].size());
+    }
+    f.close();
+    std::error_code error;
+    if (f.fail()){
+        std::filesystem::remove(temporary, error);
+        throw(std::ios_base::failure(std::string("Error writing file ")+temporary));
+    }
+    std::filesystem::rename(temporary, filename, error);
+    if (error){
+        std::filesystem::remove(temporary, error);
+        throw(std::ios_base::failure(std::string("Error writing file ")+filename));
+    }
+}
+
+
+// Color of a 5:6:5 block endpoint
+static void Unpack565(uint16_t color, unsigned char *rgb){
+
+    int r = (color >> 11) & 31;
+    int g = (color >> 5) & 63;
+    int b = color & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+
+static uint16_t Pack565(const int *rgb){
+
+    return ((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3);
+}
+
+
+// Color part of a BC1 or BC3 block, always in four-color mode: the
+// endpoints are the corners of the bounding box of the colors, moved in
+// by 1/16 so the interpolated colors cover the block better
+static void CompressColorBlock(const unsigned char *pixel, unsigned char *block){
+
+    int low[3] = { 255, 255, 255 };
+    int high[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; i++){
+        for (int c = 0; c < 3; c++){
+            low[c] = std::min(low[c], (int) pixel[i * 4 + c]);
+            high[c] = std::max(high[c], (int) pixel[i * 4 + c]);
+        }
+    }
+    for (int c = 0; c < 3; c++){
+        int inset = (high[c] - low[c]) / 16;
+        low[c] += inset;
+        high[c] -= inset;
+    }
+    uint16_t color0 = Pack565(high);
+    uint16_t color1 = Pack565(low);
+    if (color0 < color1){
+        std::swap(color0, color1);
+    }
+
+    // Palette as the decoder will see it
+    unsigned char palette[4][3];
+    Unpack565(color0, palette[0]);
+    Unpack565(color1, palette[1]);
+    for (int c = 0; c < 3; c++){
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    uint32_t index = 0;
+    if (color0 != color1){
+        for (int i = 0; i < 16; i++){
+            int best = 0;
+            int best_distance = 1 << 30;
+            for (int j = 0; j < 4; j++){
+                int distance = 0;
+                for (int c = 0; c < 3; c++){
+                    int d = (int) pixel[i * 4 + c] - palette[j][c];
+                    distance += d * d;
+                }
+                if (distance < best_distance){
+                    best = j;
+                    best_distance = distance;
+                }
+            }
+            index |= (uint32_t) best << (2 * i);
+        }
+    }
+
+    block[0] = color0 & 0xff;
+    block[1] = color0 >> 8;
+    block[2] = color1 & 0xff;
+    block[3] = color1 >> 8;
+    memcpy(block + 4, &index, 4);
+}
+
+
+// Alpha part of a BC3 block, in eight-value mode between the extremes
+static void CompressAlphaBlock(const unsigned char *pixel, unsigned char *block){
+
+    int alpha0 = 0;
+    int alpha1 = 255;
+    for (int i = 0; i < 16; i++){
+        alpha0 = std::max(alpha0, (int) pixel[i * 4 + 3]);
+        alpha1 = std::min(alpha1, (int) pixel[i * 4 + 3]);
+    }
+
+    uint64_t index = 0;
+    if (alpha0 != alpha1){
+        int palette[8];
+        palette[0] = alpha0;
+        palette[1] = alpha1;
+        for (int j = 1; j < 7; j++){
+            palette[j + 1] = ((7 - j) * alpha0 + j * alpha1) / 7;
+        }
+        for (int i = 0; i < 16; i++){
+            int best = 0;
+            for (int j = 1; j < 8; j++){
+                if (abs(pixel[i * 4 + 3] - palette[j]) < abs(pixel[i * 4 + 3] - palette[best])){
+                    best = j;
+                }
+            }
+            index |= (uint64_t) best << (3 * i);
+        }
+    }
+
+    block[0] = alpha0;
+    block[1] = alpha1;
+    for (int i = 0; i < 6; i++){
+        block[2 + i] = (index >> (8 * i)) & 0xff;
+    }
+}
+
+
+void CompressTexture(TextureFormat format, const unsigned char *image, int width, int height, std::vector<unsigned char> &block){
+
+    if (format == TextureRGBA8){
+        block.assign(image, image + (size_t) width * height * 4);
+        return;
+    }
+
+    size_t block_size = (format == TextureBC1) ? 8 : 16;
+    block.resize(TextureLevelSize(format, width, height));
+    unsigned char *out = &block[0];
+    for (int y = 0; y < height; y += 4){
+        for (int x = 0; x < width; x += 4){
+            // Blocks past the edge of the image repeat its last texels
+            unsigned char pixel[16 * 4];
+            for (int i = 0; i < 16; i++){
+                int px = std::min(x + i % 4, width - 1);
+                int py = std::min(y + i / 4, height - 1);
+                memcpy(pixel + i * 4, image + ((size_t) py * width + px) * 4, 4);
+            }
+            if (format == TextureBC3){
+                CompressAlphaBlock(pixel, out);
+                CompressColorBlock(pixel, out + 8);
+            } else {
+                CompressColorBlock(pixel, out);
+            }
+            out += block_size;
+        }
+    }
+}
+
+
+void DecompressTexture(TextureFormat format, const unsigned char *block, int width, int height, std::vector<unsigned char> &image){
+
+    if (format == TextureRGBA8){
+        image.assign(block, block + (size_t) width * height * 4);
+        return;
+    }
+
+    size_t block_size = (format == TextureBC1) ? 8 : 16;
+    image.resize((size_t) width * height * 4);
+    for (int y = 0; y < height; y += 4){
+        for (int x = 0; x < width; x += 4){
+            const unsigned char *color = (format == TextureBC3) ? block + 8 : block;
+
+            // Color palette; BC1 blocks with color0 <= color1 have three
+            // colors and transparent black
+            uint16_t color0 = color[0] | (color[1] << 8);
+            uint16_t color1 = color[2] | (color[3] << 8);
+            unsigned char palette[4][4];
+            Unpack565(color0, palette[0]);
+            Unpack565(color1, palette[1]);
+            palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+            if ((format == TextureBC3) || (color0 > color1)){
+                for (int c = 0; c < 3; c++){
+                    palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                    palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+                }
+            } else {
+                for (int c = 0; c < 3; c++){
+                    palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                    palette[3][c] = 0;
+                }
+                palette[3][3] = 0;
+            }
+            uint32_t index;
+            memcpy(&index, color + 4, 4);
+
+            // Alpha palette of BC3 blocks
+            int alpha[8];
+            uint64_t alpha_index = 0;
+            if (format == TextureBC3){
+                alpha[0] = block[0];
+                alpha[1] = block[1];
+                if (alpha[0] > alpha[1]){
+                    for (int j = 1; j < 7; j++){
+                        alpha[j + 1] = ((7 - j) * alpha[0] + j * alpha[1]) / 7;
+                    }
+                } else {
+                    for (int j = 1; j < 5; j++){
+                        alpha[j + 1] = ((5 - j) * alpha[0] + j * alpha[1]) / 5;
+                    }
+                    alpha[6] = 0;
+                    alpha[7] = 255;
+                }
+                for (int i = 0; i < 6; i++){
+                    alpha_index |= (uint64_t) block[2 + i] << (8 * i);
+                }
+            }
+
+            for (int i = 0; i < 16; i++){
+                int px = x + i % 4;
+                int py = y + i / 4;
+                if ((px >= width) || (py >= height)){
+                    continue;
+                }
+                unsigned char *out = &image[((size_t) py * width + px) * 4];
+                memcpy(out, palette[(index >> (2 * i)) & 3], 4);
+                if (format == TextureBC3){
+                    out[3] = alpha[(alpha_index >> (3 * i)) & 7];
+                }
+            }
+            block += block_size;
+        }
+    }
+}
+
+} // namespace game
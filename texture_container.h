@@ -0,0 +1,71 @@
+#ifndef TEXTURE_CONTAINER_H_
+#define TEXTURE_CONTAINER_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include "mesh_cache.h"
+
+// Identifies texture containers; bump the version when the layout changes
+#define TEXTURE_CONTAINER_MAGIC 0x58455447 // "GTEX"
+#define TEXTURE_CONTAINER_VERSION 1
+// Extension of texture containers. A texture whose image has a container
+// next to it with the same name is loaded from the container
+#define TEXTURE_CONTAINER_EXTENSION ".gtex"
+
+namespace game {
+
+    // Pixel formats of a container
+    typedef enum TextureFormatType { TextureRGBA8, TextureBC1, TextureBC3 } TextureFormat;
+
+    // Header of a container, followed by 'level_num' level descriptions
+    // and then the level data, from the full size down to 1x1
+    struct TextureContainerHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t format;
+        uint32_t width;
+        uint32_t height;
+        uint32_t level_num;
+    };
+
+    // One mipmap level of a container
+    struct TextureLevel {
+        uint32_t width;
+        uint32_t height;
+        uint64_t offset; // From the start of the file
+        uint64_t size; // Bytes
+    };
+
+    // A container mapped in memory
+    struct TextureContainer {
+        MappedFile file;
+        TextureFormat format;
+        std::vector<TextureLevel> level;
+    };
+
+    // Bytes of one level of 'format'; block formats store 4x4 texel blocks
+    size_t TextureLevelSize(TextureFormat format, int width, int height);
+    // OpenGL internal format of the texture for 'format'
+    GLenum TextureInternalFormat(TextureFormat format);
+
+    // Path of the container of an image file
+    std::string GetTextureContainerPath(const std::string &filename);
+    // Map a container and check its header and levels
+    bool ReadTextureContainer(const std::string &filename, TextureContainer &container);
+    // Data of one level of a mapped container
+    const unsigned char *GetTextureLevelData(const TextureContainer &container, int level);
+    // Write a container; 'data' holds the levels from the full size down
+    void WriteTextureContainer(const std::string &filename, TextureFormat format, int width, int height, const std::vector<std::vector<unsigned char> > &data);
+
+    // Block compression of RGBA8 pixels, used by the offline converter,
+    // and decompression for drivers without S3TC support
+    void CompressTexture(TextureFormat format, const unsigned char *image, int width, int height, std::vector<unsigned char> &block);
+    void DecompressTexture(TextureFormat format, const unsigned char *block, int width, int height, std::vector<unsigned char> &image);
+
+} // namespace game
+
+#endif // TEXTURE_CONTAINER_H_
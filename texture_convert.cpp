@@ -0,0 +1,133 @@
+// Offline converter from images to texture containers
+//
+// Not part of the game executable; build it on its own, for example:
+//   g++ -O2 -std=c++17 -I<glm, glew, glfw and SOIL includes> texture_convert.cpp texture_container.cpp mesh_cache.cpp -lSOIL
+//
+// Usage: texture_convert [-rgba] image...
+// Writes image.gtex next to each image, with the whole mipmap chain
+// built here. Opaque images are stored as BC1 and images with alpha as
+// BC3, or as RGBA8 with -rgba. The game loads the container instead of
+// the image whenever it finds one
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <SOIL/SOIL.h>
+
+#include "texture_container.h"
+
+// Next mipmap level, averaging 2x2 texels; the last row or column of odd
+// sizes is folded into the last texel of the level, which then averages
+// 3 texels across
+static void make_level(const std::vector<unsigned char> &image, int width, int height, std::vector<unsigned char> &level){
+
+    int level_width = std::max(width / 2, 1);
+    int level_height = std::max(height / 2, 1);
+    level.resize((size_t) level_width * level_height * 4);
+    for (int y = 0; y < level_height; y++){
+        int y0 = y * 2;
+        int y1 = (y == level_height - 1) ? height - 1 : y * 2 + 1;
+        for (int x = 0; x < level_width; x++){
+            int x0 = x * 2;
+            int x1 = (x == level_width - 1) ? width - 1 : x * 2 + 1;
+            int count = (y1 - y0 + 1) * (x1 - x0 + 1);
+            for (int c = 0; c < 4; c++){
+                int sum = 0;
+                for (int sy = y0; sy <= y1; sy++){
+                    for (int sx = x0; sx <= x1; sx++){
+                        sum += image[((size_t) sy * width + sx) * 4 + c];
+                    }
+                }
+                level[((size_t) y * level_width + x) * 4 + c] = (sum + count / 2) / count;
+            }
+        }
+    }
+}
+
+
+static bool convert(const char *filename, bool rgba){
+
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+    int width, height, channels;
+    unsigned char *pixels = SOIL_load_image(filename, &width, &height, &channels, SOIL_LOAD_RGBA);
+    if (!pixels){
+        fprintf(stderr, "Error loading %s: %s\n", filename, SOIL_last_result());
+        return false;
+    }
+    std::vector<unsigned char> image(pixels, pixels + (size_t) width * height * 4);
+    SOIL_free_image_data(pixels);
+
+    // BC1 has no alpha worth the name: keep BC3 for images that use it
+    game::TextureFormat format = game::TextureBC1;
+    if (rgba){
+        format = game::TextureRGBA8;
+    } else {
+        for (size_t i = 3; i < image.size(); i += 4){
+            if (image[i] != 255){
+                format = game::TextureBC3;
+                break;
+            }
+        }
+    }
+
+    // Every level down to 1x1, each built from the previous one
+    std::vector<std::vector<unsigned char> > data;
+    int level_width = width;
+    int level_height = height;
+    while (true){
+        data.push_back(std::vector<unsigned char>());
+        game::CompressTexture(format, &image[0], level_width, level_height, data.back());
+        if ((level_width == 1) && (level_height == 1)){
+            break;
+        }
+        std::vector<unsigned char> level;
+        make_level(image, level_width, level_height, level);
+        image.swap(level);
+        level_width = std::max(level_width / 2, 1);
+        level_height = std::max(level_height / 2, 1);
+    }
+
+    std::string output = game::GetTextureContainerPath(filename);
+    try {
+        game::WriteTextureContainer(output, format, width, height, data);
+    }
+    catch (std::exception &e){
+        fprintf(stderr, "%s\n", e.what());
+        return false;
+    }
+
+    size_t bytes = 0;
+    for (unsigned int i = 0; i < data.size(); i++){
+        bytes += data[i].size();
+    }
+    const char *format_name[] = { "RGBA8", "BC1", "BC3" };
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    printf("%s: %dx%d, %zu levels, %s, %.2f MB (%.2f MB as RGBA8 with mipmaps), %.0f ms\n", output.c_str(), width, height, data.size(), format_name[format], bytes / 1e6, (size_t) width * height * 4 * 4 / 3 / 1e6, elapsed.count() * 1000.0);
+    return true;
+}
+
+
+int main(int argc, char *argv[]){
+
+    bool rgba = false;
+    int file_num = 0;
+    bool ok = true;
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "-rgba") == 0){
+            rgba = true;
+            continue;
+        }
+        ok = convert(argv[i], rgba) && ok;
+        file_num++;
+    }
+    if (file_num == 0){
+        fprintf(stderr, "Usage: %s [-rgba] image...\n", argv[0]);
+        return 1;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -1,4 +1,5 @@
 #version 130
+#extension GL_ARB_uniform_buffer_object : require
 
 // Vertex buffer
 in vec3 vertex;
@@ -8,10 +9,18 @@ in vec2 uv;
 
 // Uniform (global) buffer
 uniform mat4 world_mat;
-uniform mat4 view_mat;
-uniform mat4 projection_mat;
 uniform mat4 normal_mat;
 
+// Per-frame constants shared by all programs (see frame_globals.h)
+layout(std140) uniform FrameGlobals {
+    mat4 view_mat;
+    mat4 projection_mat;
+    vec4 camera_position;
+    vec4 light_position[2];
+    vec4 material_light_position[2];
+    vec4 timer;
+};
+
 // Attributes forwarded to the fragment shader
 out vec3 position_interp;
 out vec3 normal_interp;
@@ -19,9 +28,6 @@ out vec4 color_interp;
 out vec2 uv_interp;
 out vec3 light_pos;
 
-// Material attributes (constants)
-uniform vec3 light_position = vec3(-0.5, -0.5, 1.5);
-
 
 void main()
 {
@@ -35,5 +41,5 @@ void main()
 
     uv_interp = uv;
 
-    light_pos = vec3(view_mat * vec4(light_position, 1.0));
+    light_pos = vec3(view_mat * material_light_position[0]);
 }
@@ -0,0 +1,79 @@
+#include "thread_pool.h"
+
+namespace game {
+
+ThreadPool::ThreadPool(void){
+
+    stop_ = false;
+}
+
+
+ThreadPool::~ThreadPool(){
+
+    Stop();
+}
+
+
+void ThreadPool::Start(int thread_num){
+
+    if (!thread_.empty()){
+        return;
+    }
+
+    stop_ = false;
+    for (int i = 0; i < thread_num; i++){
+        thread_.push_back(std::thread(&ThreadPool::Run, this));
+    }
+}
+
+
+void ThreadPool::Submit(std::function<void(void)> task){
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_.push_back(task);
+    }
+    condition_.notify_one();
+}
+
+
+void ThreadPool::Stop(void){
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        task_.clear();
+    }
+    condition_.notify_all();
+
+    for (int i = 0; i < thread_.size(); i++){
+        thread_[i].join();
+    }
+    thread_.clear();
+}
+
+
+bool ThreadPool::IsStarted(void) const {
+
+    return !thread_.empty();
+}
+
+
+void ThreadPool::Run(void){
+
+    while (true){
+        std::function<void(void)> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]{ return stop_ || !task_.empty(); });
+            if (stop_){
+                return;
+            }
+            task = task_.front();
+            task_.pop_front();
+        }
+        task();
+    }
+}
+
+} // namespace game
@@ -0,0 +1,48 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace game {
+
+    // Fixed set of worker threads running queued tasks in order
+    // Tasks must not use OpenGL: the context belongs to the main thread
+    class ThreadPool {
+
+        public:
+            // Constructor and destructor
+            ThreadPool(void);
+            ~ThreadPool();
+
+            // Create the worker threads; does nothing if already started
+            void Start(int thread_num);
+            // Queue a task for the next free worker
+            void Submit(std::function<void(void)> task);
+            // Drop the tasks not started yet and wait for the running ones
+            void Stop(void);
+            bool IsStarted(void) const;
+
+        private:
+            std::vector<std::thread> thread_;
+            std::deque<std::function<void(void)> > task_;
+            std::mutex mutex_;
+            std::condition_variable condition_;
+            bool stop_;
+
+            // Loop of one worker
+            void Run(void);
+
+            // Threads are not copied
+            ThreadPool(const ThreadPool &);
+            ThreadPool &operator=(const ThreadPool &);
+
+    }; // class ThreadPool
+
+} // namespace game
+
+#endif // THREAD_POOL_H_
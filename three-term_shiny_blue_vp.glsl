@@ -1,6 +1,7 @@
 // Illumination based on the traditional three-term model
 
 #version 130
+#extension GL_ARB_uniform_buffer_object : require
 
 // Vertex buffer
 in vec3 vertex;
@@ -9,21 +10,23 @@ in vec3 color;
 
 // Uniform (global) buffer
 uniform mat4 world_mat;
-uniform mat4 view_mat;
-uniform mat4 projection_mat;
 uniform mat4 normal_mat;
 
+// Per-frame constants shared by all programs (see frame_globals.h)
+layout(std140) uniform FrameGlobals {
+    mat4 view_mat;
+    mat4 projection_mat;
+    vec4 camera_position;
+    vec4 light_position[2];
+    vec4 material_light_position[2];
+    vec4 timer;
+};
+
 // Attributes forwarded to the fragment shader
 out vec3 position_interp;
 out vec3 normal_interp;
 out vec3 light_pos;
 
-// Material attributes (constants)
-//
-// Could be loaded from a configuration file and also passed with the
-// uniform buffer
-vec3 light_position = vec3(-0.5, -0.5, 1.5);
-
 
 void main()
 {
@@ -37,5 +40,5 @@ void main()
     normal_interp = vec3(normal_mat * vec4(normal, 0.0));
 
     // Transform light position to align with view
-    light_pos = vec3(view_mat * vec4(light_position, 1.0));
+    light_pos = vec3(view_mat * material_light_position[0]);
 }
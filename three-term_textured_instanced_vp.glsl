@@ -0,0 +1,60 @@
+// Illumination based on the traditional three-term model
+// Instanced variant: each instance brings its own world matrix
+
+#version 130
+#extension GL_ARB_uniform_buffer_object : require
+
+// Vertex buffer
+in vec3 vertex;
+in vec3 normal;
+in vec3 color;
+in vec2 uv;
+in mat4 instance_mat; // Per-instance world matrix
+
+// Uniform (global) buffer
+uniform mat4 world_mat; // Transformation of the whole batch
+uniform mat4 normal_mat;
+
+// Per-frame constants shared by all programs (see frame_globals.h)
+layout(std140) uniform FrameGlobals {
+    mat4 view_mat;
+    mat4 projection_mat;
+    vec4 camera_position;
+    vec4 light_position[2];
+    vec4 material_light_position[2];
+    vec4 timer;
+};
+
+// Attributes forwarded to the fragment shader
+out vec3 position_interp;
+out vec3 normal_interp;
+out vec4 color_interp;
+out vec2 uv_interp;
+out vec3 light_pos[2];
+out vec3 camera_pos;
+
+
+void main()
+{
+    mat4 instance_world = world_mat * instance_mat;
+
+    // Transform vertex position
+    gl_Position = projection_mat * view_mat * instance_world * vec4(vertex, 1.0);
+
+    // Transform vertex position without including projection
+    position_interp = vec3(view_mat * instance_world * vec4(vertex, 1.0));
+
+    // Transform normal; the instance part assumes uniform scaling, the
+    // normal is renormalized in the fragment program
+    normal_interp = vec3(normal_mat * vec4(mat3(instance_mat) * normal, 0.0));
+
+	// Colors
+	color_interp = vec4(color, 1.0);
+
+	// Uv coordinates
+    uv_interp = uv;
+
+    // Transform light position to align with view
+    light_pos[0] = vec3(view_mat * light_position[0]);
+	light_pos[1] = vec3(view_mat * light_position[1]);
+}
@@ -1,6 +1,7 @@
 // Illumination based on the traditional three-term model
 
 #version 130
+#extension GL_ARB_uniform_buffer_object : require
 
 // Vertex buffer
 in vec3 vertex;
@@ -9,10 +10,17 @@ in vec3 color;
 
 // Uniform (global) buffer
 uniform mat4 world_mat;
-uniform mat4 view_mat;
-uniform mat4 projection_mat;
 uniform mat4 normal_mat;
-uniform vec3 cameraPos;
+
+// Per-frame constants shared by all programs (see frame_globals.h)
+layout(std140) uniform FrameGlobals {
+    mat4 view_mat;
+    mat4 projection_mat;
+    vec4 camera_position;
+    vec4 light_position[2];
+    vec4 material_light_position[2];
+    vec4 timer;
+};
 
 // Attributes forwarded to the fragment shader
 out vec3 position_interp;
@@ -20,17 +28,10 @@ out vec3 normal_interp;
 out vec3 camera_pos;
 out vec3 light_pos[2];
 
-// Material attributes (constants)
-//
-// Could be loaded from a configuration file and also passed with the
-// uniform buffer
-vec3 light_position = vec3(-0.5, -0.5, 1.5);
-vec3 light_position2 = vec3(4.0, -1.0, -1.0);
-
 
 void main()
 {
-    camera_pos = cameraPos;
+    camera_pos = camera_position.xyz;
     // Transform vertex position
     gl_Position = projection_mat * view_mat * world_mat * vec4(vertex, 1.0);
 
@@ -41,6 +42,6 @@ void main()
     normal_interp = vec3(normal_mat * vec4(normal, 0.0));
 
     // Transform light position to align with view
-    light_pos[0] = vec3(view_mat * vec4(light_position, 1.0));
-	light_pos[1] = vec3(view_mat * vec4(light_position2, 1.0));
+    light_pos[0] = vec3(view_mat * material_light_position[0]);
+	light_pos[1] = vec3(view_mat * material_light_position[1]);
 }